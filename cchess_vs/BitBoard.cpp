@@ -0,0 +1,48 @@
+﻿#include "BitBoard.h"
+
+namespace BitBoardSpace {
+
+/* ===== BitBoard start. ===== */
+const wstring BitBoard::toString() const
+{
+    wostringstream wos{};
+    for (int row = BOARDROWNUM - 1; row >= 0; --row) {
+        for (int col = 0; col < BOARDCOLNUM; ++col)
+            wos << (test(row * BOARDCOLNUM + col) ? L'1' : L'.');
+        wos << L'\n';
+    }
+    return wos.str();
+}
+/* ===== BitBoard end. ===== */
+
+/* ===== BitBoards start. ===== */
+void BitBoards::put(PieceColor color, PieceKind kind, int index)
+{
+    pieces_[static_cast<int>(color)][static_cast<int>(kind)].set(index);
+    colors_[static_cast<int>(color)].set(index);
+    occupied_.set(index);
+}
+
+void BitBoards::remove(PieceColor color, PieceKind kind, int index)
+{
+    pieces_[static_cast<int>(color)][static_cast<int>(kind)].reset(index);
+    colors_[static_cast<int>(color)].reset(index);
+    occupied_.reset(index);
+}
+
+void BitBoards::clear()
+{
+    *this = BitBoards{};
+}
+
+const wstring BitBoards::toString() const
+{
+    wostringstream wos{};
+    for (auto color : { PieceColor::RED, PieceColor::BLACK })
+        wos << (color == PieceColor::RED ? L"red:\n" : L"black:\n") << pieces(color).toString();
+    wos << L"occupied:\n"
+        << occupied_.toString();
+    return wos.str();
+}
+/* ===== BitBoards end. ===== */
+}
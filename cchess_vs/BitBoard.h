@@ -0,0 +1,135 @@
+﻿//#pragma once
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "ChessType.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace BitBoardSpace {
+
+// 64位整数最低位1的序号（bits不为0）
+inline int getLowBitIndex(unsigned long long bits)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index{};
+    _BitScanForward64(&index, bits);
+    return index;
+#elif defined(_MSC_VER)
+    unsigned long index{};
+    if (_BitScanForward(&index, static_cast<unsigned long>(bits)))
+        return index;
+    _BitScanForward(&index, static_cast<unsigned long>(bits >> 32));
+    return index + 32;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+// 64位整数中1的个数
+inline int getBitCount(unsigned long long bits)
+{
+#ifdef _MSC_VER
+    bits = bits - ((bits >> 1) & 0x5555555555555555ULL);
+    bits = (bits & 0x3333333333333333ULL) + ((bits >> 2) & 0x3333333333333333ULL);
+    bits = (bits + (bits >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((bits * 0x0101010101010101ULL) >> 56);
+#else
+    return __builtin_popcountll(bits);
+#endif
+}
+
+// 位棋盘类：90个位置按序号(row * 9 + col)存放，lo_存0~63，hi_存64~89
+class BitBoard {
+
+public:
+    constexpr BitBoard() = default;
+    constexpr BitBoard(unsigned long long lo, unsigned long long hi)
+        : lo_{ lo }
+        , hi_{ hi & HiMask_ }
+    {
+    }
+
+    constexpr bool test(int index) const
+    {
+        return index < 64 ? (lo_ >> index) & 1 : (hi_ >> (index - 64)) & 1;
+    }
+    constexpr void set(int index)
+    {
+        if (index < 64)
+            lo_ |= 1ULL << index;
+        else
+            hi_ |= 1ULL << (index - 64);
+    }
+    void reset(int index)
+    {
+        if (index < 64)
+            lo_ &= ~(1ULL << index);
+        else
+            hi_ &= ~(1ULL << (index - 64));
+    }
+
+    bool any() const { return lo_ || hi_; }
+    int count() const { return getBitCount(lo_) + getBitCount(hi_); }
+    // 序号最小的位置，无位置则返回-1
+    int first() const
+    {
+        return lo_ ? getLowBitIndex(lo_) : (hi_ ? 64 + getLowBitIndex(hi_) : -1);
+    }
+    // 取出序号最小的位置并清除（须any()为真）
+    int popFirst()
+    {
+        int index{};
+        if (lo_) {
+            index = getLowBitIndex(lo_);
+            lo_ &= lo_ - 1;
+        } else {
+            index = 64 + getLowBitIndex(hi_);
+            hi_ &= hi_ - 1;
+        }
+        return index;
+    }
+
+    BitBoard operator&(const BitBoard& other) const { return BitBoard{ lo_ & other.lo_, hi_ & other.hi_ }; }
+    BitBoard operator|(const BitBoard& other) const { return BitBoard{ lo_ | other.lo_, hi_ | other.hi_ }; }
+    BitBoard operator^(const BitBoard& other) const { return BitBoard{ lo_ ^ other.lo_, hi_ ^ other.hi_ }; }
+    BitBoard operator~() const { return BitBoard{ ~lo_, ~hi_ }; }
+    BitBoard& operator&=(const BitBoard& other) { return *this = *this & other; }
+    BitBoard& operator|=(const BitBoard& other) { return *this = *this | other; }
+    BitBoard& operator^=(const BitBoard& other) { return *this = *this ^ other; }
+    bool operator==(const BitBoard& other) const { return lo_ == other.lo_ && hi_ == other.hi_; }
+    bool operator!=(const BitBoard& other) const { return !(*this == other); }
+
+    const wstring toString() const;
+
+private:
+    static constexpr unsigned long long HiMask_{ (1ULL << (SEATNUM - 64)) - 1 };
+
+    unsigned long long lo_{ 0 }, hi_{ 0 };
+};
+
+// 一副棋局的位棋盘集合：按颜色、种类分别记录棋子位置
+class BitBoards {
+
+public:
+    const BitBoard& pieces(PieceColor color, PieceKind kind) const
+    {
+        return pieces_[static_cast<int>(color)][static_cast<int>(kind)];
+    }
+    const BitBoard& pieces(PieceColor color) const { return colors_[static_cast<int>(color)]; }
+    const BitBoard& occupied() const { return occupied_; }
+
+    void put(PieceColor color, PieceKind kind, int index);
+    void remove(PieceColor color, PieceKind kind, int index);
+    void clear();
+
+    const wstring toString() const;
+
+private:
+    BitBoard pieces_[2][7]{}, colors_[2]{}, occupied_{};
+};
+}
+
+#endif
@@ -1,4 +1,5 @@
 ﻿#include "Board.h"
+#include "BitBoard.h"
 #include "Piece.h"
 #include "Seat.h"
 
@@ -10,59 +11,46 @@ Board::Board(const wstring& pieceChars)
     , pieces_{ make_shared<Pieces>() }
     , seats_{ make_shared<Seats>() } // make_shared:动态分配内存，初始化对象并指向它
 {
+    if (!pieceChars.empty())
+        setPieces(pieceChars);
 }
 
 bool Board::isKilled(PieceColor color) const
 {
+    // 由本方将（帅）位置向外查找对方的车马炮兵及将帅对面，找到一个即返回
     bool isBottom{ isBottomSide(color) };
-    PieceColor othColor = PieceManager::getOtherColor(color);
-    //SSeat kingSeat{ pieces_->getKingPiece(color)->seat() },
-    //    othKingSeat{ pieces_->getKingPiece(othColor)->seat() };
-    SSeat kingSeat{ seats_->getKingSeat(isBottom) },
-        othKingSeat{ seats_->getKingSeat(!isBottom) };
-    int fcol{ kingSeat->col() };
-    if (fcol == othKingSeat->col()) {
-        int krow{ kingSeat->row() }, orow{ othKingSeat->row() },
-            lrow{ isBottom ? krow : orow }, urow{ isBottom ? orow : krow };
-        bool killed{ true };
-        for (int row = lrow + 1; row < urow; ++row)
-            if (seats_->getSeat(row, fcol)->piece()) { // 空棋子则继续循环
-                killed = false; // 全部是空棋子，则将帅对面
-                break;
-            }
-        if (killed)
-            return true;
-    }
-    // '获取某方可杀将棋子全部可走的位置
-    for (auto& fseat : seats_->getLiveSeats(othColor, BLANKNAME, BLANKCOL, true)) {
-        auto mvSeats = seats_->getMoveSeats(isBottom, fseat);
-        if (!mvSeats.empty() && find(mvSeats.begin(), mvSeats.end(), kingSeat) != mvSeats.end()) // 对方强子可走位置有本将位置
-            return true;
-    }
-    return false;
+    return seats_->isAttacked(PieceManager::getOtherColor(color), !isBottom, seats_->getKingIndex(isBottom));
 }
 
 bool Board::isDied(PieceColor color) const
 {
-    for (auto& fseat : seats_->getLiveSeats(color))
-        if (!__getCanMoveSeats(fseat).empty()) // 本方还有棋子可以走
-            return false;
-    return true;
+    CheckInfo checkInfo{ __getCheckInfo(color) };
+    MoveList moves{};
+    __getCanMoves(moves, checkInfo, true);
+    if (!moves.empty()) // 本方还有棋子可以走
+        return false;
+    __getCanMoves(moves, checkInfo, false);
+    return moves.empty();
+}
+
+ZobristKey Board::key() const
+{
+    return seats_->key();
 }
 
 inline SSeat_pair Board::getSeatPair(int frow, int fcol, int trow, int tcol) const
 {
-    return make_pair(seats_->getSeat(frow, fcol), seats_->getSeat(trow, tcol));
+    return SSeat_pair{ seats_->getSeat(frow, fcol), seats_->getSeat(trow, tcol) }; // 须直接引用位置表中的元素，make_pair会复制为临时对象
 }
 
 SSeat_pair Board::getSeatPair(int frowcol, int trowcol) const // 内联不成功
 {
-    return make_pair(seats_->getSeat(frowcol), seats_->getSeat(trowcol));
+    return SSeat_pair{ seats_->getSeat(frowcol), seats_->getSeat(trowcol) };
 }
 
 inline SSeat_pair Board::getSeatPair(RowCol_pair fprow_pair, RowCol_pair tprow_pair) const
 {
-    return make_pair(seats_->getSeat(fprow_pair), seats_->getSeat(tprow_pair));
+    return SSeat_pair{ seats_->getSeat(fprow_pair), seats_->getSeat(tprow_pair) };
 }
 
 inline SSeat_pair Board::getSeatPair(PRowCol_pair pprow_pair) const
@@ -115,7 +103,20 @@ const wstring Board::getZhStr(SSeat_pair seat_pair) const
 template <typename From_T1, typename From_T2>
 const RowCol_pair_vector Board::getCanMoveRowCols(From_T1 arg1, From_T2 arg2) const
 {
-    return SeatManager::getRowCols(__getCanMoveSeats(__getSeat(arg1, arg2)));
+    auto& fseat = __getSeat(arg1, arg2);
+    assert(fseat->piece());
+    CheckInfo checkInfo{ __getCheckInfo(fseat->piece()->color()) };
+    MoveList moves{};
+    __getCanMoves(moves, checkInfo, true, fseat->index());
+    __getCanMoves(moves, checkInfo, false, fseat->index());
+
+    RowCol_pair_vector rowcols{};
+    for (auto move : moves) {
+        int tindex{ MoveList::toIndex(move) };
+        rowcols.push_back(make_pair(tindex / BOARDCOLNUM, tindex % BOARDCOLNUM));
+    }
+    sort(rowcols.begin(), rowcols.end()); // 按位置排列，不区分吃子与否
+    return rowcols;
 }
 template const RowCol_pair_vector Board::getCanMoveRowCols(int arg1, int arg2) const;
 template const RowCol_pair_vector Board::getCanMoveRowCols(const wstring& arg1, RecFormat arg2) const;
@@ -125,14 +126,226 @@ const RowCol_pair_vector Board::getLiveRowCols(PieceColor color) const
     return SeatManager::getRowCols(seats_->getLiveSeats(color));
 }
 
+void Board::getCanMoves(MoveList& moves, PieceColor color, bool isCapture) const
+{
+    __getCanMoves(moves, __getCheckInfo(color), isCapture);
+}
+
+CheckInfo Board::getCheckInfo(PieceColor color) const
+{
+    return __getCheckInfo(color);
+}
+
+void Board::getCanMoves(MoveList& moves, const CheckInfo& checkInfo, bool isCapture) const
+{
+    __getCanMoves(moves, checkInfo, isCapture);
+}
+
+bool Board::isCanMove(const CheckInfo& checkInfo, MoveCode move) const
+{
+    int findex{ MoveList::fromIndex(move) }, tindex{ MoveList::toIndex(move) };
+    if (findex >= SEATNUM || tindex >= SEATNUM)
+        return false;
+    auto& mailbox = seats_->mailbox();
+    unsigned char fcode{ mailbox.code(Mailbox::getSquare(findex)) }, tcode{ mailbox.code(Mailbox::getSquare(tindex)) };
+    if (fcode == Mailbox::EMPTY || Mailbox::getColor(fcode) != checkInfo.color
+        || (tcode != Mailbox::EMPTY && Mailbox::getColor(tcode) == checkInfo.color))
+        return false;
+    MoveList moves{};
+    __getCanMoves(moves, checkInfo, tcode != Mailbox::EMPTY, findex);
+    return find(moves.begin(), moves.end(), move) != moves.end();
+}
+
+bool Board::isCapture(MoveCode move) const
+{
+    return seats_->mailbox().code(Mailbox::getSquare(MoveList::toIndex(move))) != Mailbox::EMPTY;
+}
+
+int Board::getPieceCount(PieceColor color, PieceKind kind) const
+{
+    return seats_->pieceLists().count(color, kind);
+}
+
+int Board::getPieceCount() const
+{
+    int count{ 0 };
+    for (auto color : { PieceColor::RED, PieceColor::BLACK })
+        for (int kind = 0; kind < 7; ++kind)
+            count += seats_->pieceLists().count(color, static_cast<PieceKind>(kind));
+    return count;
+}
+
+int Board::getKindValue(int index) const
+{
+    unsigned char code{ seats_->mailbox().code(Mailbox::getSquare(index)) };
+    return code == Mailbox::EMPTY ? 0 : EvalManager::params().kindValues[static_cast<int>(Mailbox::getKind(code))];
+}
+
+const SPiece Board::movTo(MoveCode move)
+{
+    addHistory(move);
+    SSeat tseat{ seats_->getIndexSeat(MoveList::toIndex(move)) };
+    return seats_->getIndexSeat(MoveList::fromIndex(move))->movTo(tseat);
+}
+
+void Board::movBack(MoveCode move, const SPiece& eatPiece)
+{
+    SSeat fseat{ seats_->getIndexSeat(MoveList::fromIndex(move)) };
+    seats_->getIndexSeat(MoveList::toIndex(move))->movTo(fseat, eatPiece);
+    removeHistory();
+}
+
+void Board::setHistory(const Board& board)
+{
+    ZobristKey sideKey{ key() ^ board.key() };
+    history_ = board.history_;
+    for (auto& entry : history_)
+        entry.key ^= sideKey;
+}
+
+Repetition Board::getRepetition()
+{
+    Repetition repetition{ false, RepeatKind::IDLE, RepeatKind::IDLE };
+    ZobristKey curKey{ key() };
+    int start{ static_cast<int>(history_.size()) - 2 };
+    for (; start >= 0; start -= 2) {
+        // 吃子之前的局面不会再现；空着之前的局面走子方不同
+        auto &entry = history_[start], &nextEntry = history_[start + 1];
+        if (entry.isCapture || nextEntry.isCapture || !entry.move || !nextEntry.move)
+            return repetition;
+        if (entry.key == curKey)
+            break;
+    }
+    if (start < 0)
+        return repetition;
+
+    // 当前局面即循环的起始局面：重演循环中的着法（均不吃子），逐步判断后退回
+    int end{ static_cast<int>(history_.size()) };
+    bool allChecks[2]{ true, true }, hasChases[2]{ false, false };
+    vector<const Piece*> commonChaseds[2]{};
+    for (int i = start; i < end; ++i) {
+        MoveCode move{ history_[i].move };
+        SSeat fseat{ seats_->getIndexSeat(MoveList::fromIndex(move)) },
+            tseat{ seats_->getIndexSeat(MoveList::toIndex(move)) };
+        vector<Chase> befores{};
+        __getChases(fseat->piece()->color(), befores);
+        fseat->movTo(tseat);
+
+        int side{ (i - start) % 2 };
+        vector<const Piece*> chaseds{};
+        if (__isCheckOrChase(move, befores, chaseds))
+            continue;
+        allChecks[side] = false;
+        // 非将军的着法须连续捉同一棋子
+        auto& commons = commonChaseds[side];
+        if (!hasChases[side]) {
+            hasChases[side] = true;
+            commons = chaseds;
+        } else
+            commons.erase(remove_if(commons.begin(), commons.end(), [&](const Piece* piece) {
+                return find(chaseds.begin(), chaseds.end(), piece) == chaseds.end();
+            }),
+                commons.end());
+    }
+    for (int i = end - 1; i >= start; --i) {
+        MoveCode move{ history_[i].move };
+        SSeat fseat{ seats_->getIndexSeat(MoveList::fromIndex(move)) };
+        seats_->getIndexSeat(MoveList::toIndex(move))->movTo(fseat);
+    }
+
+    RepeatKind kinds[2]{};
+    for (int side = 0; side < 2; ++side)
+        kinds[side] = (allChecks[side] ? RepeatKind::CHECK
+                                       : (hasChases[side] && !commonChaseds[side].empty() ? RepeatKind::CHASE
+                                                                                          : RepeatKind::IDLE));
+    return Repetition{ true, kinds[0], kinds[1] };
+}
+
+int Board::evaluate(PieceColor color) const
+{
+    if (NnueManager::isLoaded())
+        return NnueManager::evaluate(seats_->accumulator(), isBottomSide(color));
+    auto& evaluation = seats_->evaluation();
+    PieceColor othColor{ PieceManager::getOtherColor(color) };
+    return evaluation.value(color, isBottomSide(color)) - evaluation.value(othColor, isBottomSide(othColor));
+}
+
+int Board::evaluateScalar(PieceColor color) const
+{
+    if (NnueManager::isLoaded())
+        return NnueManager::evaluateScalar(seats_->pieceLists(), isBottomSide(color));
+    return evaluate(color);
+}
+
+int Board::see(MoveCode move) const
+{
+    int findex{ MoveList::fromIndex(move) };
+    PieceColor color{ Mailbox::getColor(seats_->mailbox().code(Mailbox::getSquare(findex))) };
+    return seats_->see(color, isBottomSide(color), findex, MoveList::toIndex(move));
+}
+
+long long Board::perft(PieceColor color, int depth) const
+{
+    return isBottomSide(color) ? __perft<true>(color, depth) : __perft<false>(color, depth);
+}
+
+long long Board::perftMailbox(PieceColor color, int depth) const
+{
+    Mailbox mailbox{ seats_->mailbox() };
+    return mailbox.perft(color, isBottomSide(color), depth);
+}
+
+const vector<pair<PRowCol_pair, long long>>
+Board::perftDivide(PieceColor color, int depth, int threadNum) const
+{
+    vector<pair<PRowCol_pair, long long>> counts{};
+    MoveList moves{};
+    getCanMoves(moves, color, true);
+    getCanMoves(moves, color, false);
+    for (auto move : moves) {
+        int findex{ MoveList::fromIndex(move) }, tindex{ MoveList::toIndex(move) };
+        counts.emplace_back(make_pair(make_pair(findex / BOARDCOLNUM, findex % BOARDCOLNUM),
+                                make_pair(tindex / BOARDCOLNUM, tindex % BOARDCOLNUM)),
+            0);
+    }
+    if (depth <= 1) {
+        for (auto& count : counts)
+            count.second = 1;
+        return counts;
+    }
+
+    // 棋盘、棋子对象不能跨线程共享，每个线程据棋子字符串新建副本，以本棋盘的走子生成器计数
+    const wstring pieceChars{ getPieceChars() };
+    PieceColor othColor{ PieceManager::getOtherColor(color) };
+    int countsSize = counts.size();
+    atomic<int> nextIndex{ 0 };
+    auto __worker = [&]() {
+        Board board{ pieceChars };
+        for (int index = nextIndex++; index < countsSize; index = nextIndex++) {
+            auto eatPiece = board.movTo(moves[index]);
+            counts[index].second = board.perft(othColor, depth - 1);
+            board.movBack(moves[index], eatPiece);
+        }
+    };
+    vector<thread> threads{};
+    for (int i = 1; i < min(max(threadNum, 1), countsSize); ++i)
+        threads.emplace_back(__worker);
+    __worker(); // 本线程同样参与计算
+    for (auto& th : threads)
+        th.join();
+    return counts;
+}
+
 void Board::setPieces(const wstring& pieceChars)
 {
+    history_.clear();
     seats_->setBoardPieces(pieces_->getBoardPieces(pieceChars));
     __setBottomSide();
 }
 
 void Board::changeSide(const ChangeType ct)
 {
+    history_.clear();
     seats_->changeSide(ct, pieces_);
     __setBottomSide();
 }
@@ -242,25 +455,100 @@ SSeat_pair Board::__getSeatPairFromZhStr(const wstring& zhStr) const
     }
     //assert(zhStr == getZh(fseat, tseat));
 
-    return make_pair(fseat, tseat);
+    return SSeat_pair{ seats_->getSeat(fseat->rowcol()), seats_->getSeat(tseat->rowcol()) };
 }
 
-SSeat_vector Board::__getCanMoveSeats(const SSeat& fseat) const
+void Board::__getChases(PieceColor color, vector<Chase>& chases) const
 {
-    assert(fseat->piece());
-    PieceColor color{ fseat->piece()->color() };
-    //SPiece toPiece;
-    auto seats = seats_->getMoveSeats(isBottomSide(color), fseat);
-    auto fseat_cp = fseat; // 新建一个非const的副本，供下面测试是否被将军使用 (参见:c++ Primer Page.192)
-    auto pos = remove_if(seats.begin(), seats.end(),
-        [&](SSeat& tseat) {
-            // 移动棋子后，检测是否会被对方将军
-            auto& eatPiece = fseat_cp->movTo(tseat);
-            bool killed{ isKilled(color) };
-            tseat->movTo(fseat_cp, eatPiece);
-            return killed;
-        });
-    return SSeat_vector{ seats.begin(), pos };
+    PieceColor othColor{ PieceManager::getOtherColor(color) };
+    MoveList moves{};
+    getCanMoves(moves, color, true);
+    for (auto capture : moves) {
+        int findex{ MoveList::fromIndex(capture) }, tindex{ MoveList::toIndex(capture) };
+        const SPiece& piece{ seats_->getIndexSeat(findex)->piece() };
+        const SPiece& eatPiece{ seats_->getIndexSeat(tindex)->piece() };
+        bool isPawnCrossed{ (tindex / BOARDCOLNUM >= BOARDROWNUM / 2) == isBottomSide(othColor) };
+        if (piece->kind() != PieceKind::KING && piece->kind() != PieceKind::PAWN
+            && (eatPiece->kind() != PieceKind::PAWN || isPawnCrossed) && see(capture) > 0)
+            chases.push_back(make_pair(piece.get(), eatPiece.get()));
+    }
+}
+
+bool Board::__isCheckOrChase(MoveCode move, const vector<Chase>& befores, vector<const Piece*>& chaseds) const
+{
+    const Piece* piece{ seats_->getIndexSeat(MoveList::toIndex(move))->piece().get() };
+    PieceColor color{ piece->color() };
+    if (isKilled(PieceManager::getOtherColor(color)))
+        return true;
+
+    vector<Chase> chases{};
+    __getChases(color, chases);
+    for (auto& chase : chases)
+        if ((chase.first == piece || find(befores.begin(), befores.end(), chase) == befores.end())
+            && find(chaseds.begin(), chaseds.end(), chase.second) == chaseds.end())
+            chaseds.push_back(chase.second);
+    return false;
+}
+
+CheckInfo Board::__getCheckInfo(PieceColor color) const
+{
+    return seats_->getCheckInfo(color, isBottomSide(color));
+}
+
+void Board::__getCanMoves(MoveList& moves, const CheckInfo& checkInfo, bool isCapture, int index) const
+{
+    if (isBottomSide(checkInfo.color))
+        __getCanMoves<true>(moves, checkInfo, isCapture, index);
+    else
+        __getCanMoves<false>(moves, checkInfo, isCapture, index);
+}
+
+template <bool IsBottom>
+void Board::__getCanMoves(MoveList& moves, const CheckInfo& checkInfo, bool isCapture, int index) const
+{
+    PieceColor color{ checkInfo.color }, othColor{ PieceManager::getOtherColor(color) };
+    int start{ moves.size() };
+    if (index < 0)
+        seats_->getMoves<IsBottom>(moves, color, isCapture);
+    else
+        seats_->getMoves<IsBottom>(moves, index, isCapture);
+
+    moves.removeIf(start, [&](MoveCode move) {
+        int findex{ MoveList::fromIndex(move) }, tindex{ MoveList::toIndex(move) };
+        // 牵制子、炮架及马腿均已由局面信息给出，无须走子检验
+        if (!checkInfo.isChecked && findex != checkInfo.kingIndex)
+            return !seats_->isLegalMove(checkInfo, findex, tindex);
+
+        // 将帅的着法及应将：移动棋子后检测是否会被对方将军
+        SSeat fseat{ seats_->getIndexSeat(findex) }, tseat{ seats_->getIndexSeat(tindex) };
+        auto eatPiece = fseat->movTo(tseat);
+        bool killed{ seats_->isAttacked<!IsBottom>(othColor, seats_->pieceLists().kingIndex(color)) };
+        SeatManager::movBack(fseat, tseat, eatPiece);
+        return killed;
+    });
+}
+
+template <bool IsBottom>
+long long Board::__perft(PieceColor color, int depth) const
+{
+    if (depth <= 0)
+        return 1;
+    long long nodes{ 0 };
+    PieceColor othColor{ PieceManager::getOtherColor(color) };
+    CheckInfo checkInfo{ seats_->getCheckInfo<IsBottom>(color) };
+    MoveList moves{};
+    __getCanMoves<IsBottom>(moves, checkInfo, true);
+    __getCanMoves<IsBottom>(moves, checkInfo, false);
+    if (depth == 1) // 最后一层只计数，不走子
+        return moves.size();
+    for (auto move : moves) {
+        SSeat fseat{ seats_->getIndexSeat(MoveList::fromIndex(move)) },
+            tseat{ seats_->getIndexSeat(MoveList::toIndex(move)) };
+        auto eatPiece = fseat->movTo(tseat);
+        nodes += __perft<!IsBottom>(othColor, depth - 1);
+        SeatManager::movBack(fseat, tseat, eatPiece);
+    }
+    return nodes;
 }
 /* ===== Board end. ===== */
 
@@ -13,6 +13,8 @@ public:
     bool isBottomSide(PieceColor color) const { return bottomColor_ == color; }
     bool isKilled(PieceColor color) const;
     bool isDied(PieceColor color) const;
+    // 局面的Zobrist键值，随走子增量更新
+    ZobristKey key() const;
 
     SSeat_pair getSeatPair(int frow, int fcol, int trow, int tcol) const;
     SSeat_pair getSeatPair(int frowcol, int trowcol) const;
@@ -26,6 +28,48 @@ public:
     //SSeat_vector getCanMoveSeats(const wstring& str, RecFormat fmt) const;
 
     const RowCol_pair_vector getLiveRowCols(PieceColor color) const;
+    // color方的合法着法，分阶段生成：isCapture为真时为吃子着法，否则为不吃子着法，追加至moves
+    void getCanMoves(MoveList& moves, PieceColor color, bool isCapture) const;
+    // 分阶段生成时，将帅受攻击信息每个局面只计算一次
+    CheckInfo getCheckInfo(PieceColor color) const;
+    void getCanMoves(MoveList& moves, const CheckInfo& checkInfo, bool isCapture) const;
+    // 着法（置换表着法、杀手着法等）在本局面是否合法：只生成起点棋子的着法
+    bool isCanMove(const CheckInfo& checkInfo, MoveCode move) const;
+    // 着法是否吃子
+    bool isCapture(MoveCode move) const;
+    // color方kind种类棋子的数量；棋盘上全部棋子的数量
+    int getPieceCount(PieceColor color, PieceKind kind) const;
+    int getPieceCount() const;
+    // index位置棋子的子力价值（空位为0），供着法排序
+    int getKindValue(int index) const;
+    // 按着法编码走子（返回被吃棋子）、退回，供搜索使用：同时记入、移除局面历史
+    const SPiece movTo(MoveCode move);
+    void movBack(MoveCode move, const SPiece& eatPiece);
+    // 空着：棋盘不变，局面历史记入空着（此前的局面不再参与循环判断）
+    void movNull() { history_.push_back(HistoryEntry{ key(), 0, false }); }
+    void movNullBack() { history_.pop_back(); }
+    // 以Seat走子时（棋谱），走子之前、退回之后分别调用，维护局面历史
+    void addHistory(MoveCode move) { history_.push_back(HistoryEntry{ key(), move, isCapture(move) }); }
+    void removeHistory() { history_.pop_back(); }
+    // 接续board的局面历史（棋盘副本用于搜索时），键值按本棋盘的走子方键值调整
+    void setHistory(const Board& board);
+    // 当前局面是否在局面历史中出现过（至上一次吃子或空着为止），是则重演该循环，判断双方着法的类别
+    Repetition getRepetition();
+    // 局面评估（color方视角）：已载入神经网络则用网络评估，否则为color方子力及位置价值减去对方的
+    // 两者均随走子增量更新，无须扫描棋盘
+    int evaluate(PieceColor color) const;
+    // 神经网络评估按全部棋子从头以标量计算的结果（供检验evaluate），未载入网络则同evaluate
+    int evaluateScalar(PieceColor color) const;
+    // 着法的静态交换评估：吃子（或走至）后双方轮流以最小价值棋子吃回，走子方的子力得失
+    int see(MoveCode move) const;
+
+    // 走子生成器计数测试：color方先走，深度depth的叶结点数量
+    long long perft(PieceColor color, int depth) const;
+    // 同perft，但复制信箱棋盘以其走子生成器计数（供对照检验）
+    long long perftMailbox(PieceColor color, int depth) const;
+    // 按根着法分解计数，各根着法分配给threadNum个线程（各线程使用独立的棋盘副本）
+    const vector<pair<PRowCol_pair, long long>> perftDivide(PieceColor color, int depth,
+        int threadNum = thread::hardware_concurrency()) const;
 
     void setPieces(const wstring& pieceChars);
     void changeSide(const ChangeType ct);
@@ -38,13 +82,36 @@ private:
     shared_ptr<Pieces> pieces_;
     shared_ptr<Seats> seats_;
 
+    // 局面历史：各步走子前的键值、着法（空着为0）及是否吃子
+    struct HistoryEntry {
+        ZobristKey key;
+        MoveCode move;
+        bool isCapture;
+    };
+    vector<HistoryEntry> history_{};
+
     void __setBottomSide();
+    // 捉子：捉的棋子、被捉的棋子
+    typedef pair<const Piece*, const Piece*> Chase;
+    // color方全部的捉子：可吃且静态交换评估得利（近似于亚洲规则的捉无根子或价值较高的子，未计较假根等细节），
+    // 将帅、兵卒所捉及未过河的兵卒除外
+    void __getChases(PieceColor color, vector<Chase>& chases) const;
+    // 已走的着法是否将军；否则将所捉的棋子追加至chaseds：走动棋子的全部捉子，其他棋子走前没有的捉子（闪捉）
+    // befores为走前该方的捉子
+    bool __isCheckOrChase(MoveCode move, const vector<Chase>& befores, vector<const Piece*>& chaseds) const;
 
     const SSeat& __getSeat(int row, int col) const;
     const SSeat& __getSeat(const wstring& str, RecFormat fmt) const;
     SSeat_pair __getSeatPairFromZhStr(const wstring& zhStr) const;
 
-    SSeat_vector __getCanMoveSeats(const SSeat& fseat) const;
+    CheckInfo __getCheckInfo(PieceColor color) const;
+    // 生成index位置（-1则为全部）棋子的一个阶段的合法着法：使用本局面已计算的将帅受攻击信息
+    void __getCanMoves(MoveList& moves, const CheckInfo& checkInfo, bool isCapture, int index = -1) const;
+    // 按走子方是否底方(IsBottom)特化的着法生成及计数，每个局面只选用一次
+    template <bool IsBottom>
+    void __getCanMoves(MoveList& moves, const CheckInfo& checkInfo, bool isCapture, int index = -1) const;
+    template <bool IsBottom>
+    long long __perft(PieceColor color, int depth) const;
 };
 
 const wstring FENplusToFEN(const wstring& FENplus);
@@ -19,6 +19,11 @@ inline int ChessManual::Move::frowcol() const { return seat_pair_.first->rowcol(
 
 inline int ChessManual::Move::trowcol() const { return seat_pair_.second->rowcol(); }
 
+MoveCode ChessManual::Move::code() const
+{
+    return MoveList::getMove(seat_pair_.first->index(), seat_pair_.second->index());
+}
+
 const wstring ChessManual::Move::iccs() const
 {
     wostringstream wos{};
@@ -95,7 +100,10 @@ const wstring ChessManual::Move::toString() const
     wos << setw(2) << frowcol() << L'_' << setw(2) << trowcol()
         << L'-' << setw(4) << iccs() << L':' << setw(4) << zh()
         << L'@' << (eatPie_ ? eatPie_->name() : L'-') << L' ' << L'{' << remark() << L'}'
-        << L" next:" << nextNo_ << L" other:" << otherNo_ << L" CC_Col:" << CC_ColNo_ << L'\n';
+        << L" next:" << nextNo_ << L" other:" << otherNo_ << L" CC_Col:" << CC_ColNo_;
+    if (repetition_.isRepeated)
+        wos << L" repeat:" << static_cast<int>(repetition_.own) << L'/' << static_cast<int>(repetition_.other);
+    wos << L'\n';
     return wos.str();
 }
 /* ===== ChessManual::Move end. ===== */
@@ -145,21 +153,21 @@ void ChessManual::reset()
     __setFENplusFromFEN(PieceManager::FirstFEN(), PieceColor::RED);
     __setBoardFromInfo();
     currentMove_ = rootMove_ = make_shared<Move>();
-    movCount_ = remCount_ = remLenMax_ = maxRow_ = maxCol_ = 0;
+    movCount_ = remCount_ = remLenMax_ = maxRow_ = maxCol_ = banCount_ = 0;
 }
 
 void ChessManual::go()
 {
     if (currentMove_->next()) {
         currentMove_ = currentMove_->next();
-        currentMove_->done();
+        __done(currentMove_);
     }
 }
 
 void ChessManual::back()
 {
     if (currentMove_->prev()) {
-        currentMove_->undo();
+        __undo(currentMove_);
         currentMove_ = currentMove_->prev();
     }
 }
@@ -173,9 +181,9 @@ void ChessManual::backTo(const SMove& move)
 void ChessManual::goOther()
 {
     if (currentMove_ != rootMove_ && currentMove_->other()) {
-        currentMove_->undo();
+        __undo(currentMove_);
         currentMove_ = currentMove_->other();
-        currentMove_->done();
+        __done(currentMove_);
     }
 }
 
@@ -215,7 +223,55 @@ void ChessManual::changeSide(ChangeType ct)
     if (ct != ChangeType::ROTATE)
         __setMoveZhStrAndNums();
     for (auto& move : prevMoves)
-        move->done();
+        if (move != rootMove_) {
+            __done(move);
+            currentMove_ = move;
+        }
+}
+
+const wstring ChessManual::getStartPieceChars() const
+{
+    return FENTopieChars(FENplusToFEN(info_.at(FENKey)));
+}
+
+const vector<MoveCode> ChessManual::getMainMoves() const
+{
+    vector<MoveCode> moves{};
+    for (SMove move{ rootMove_->next() }; move; move = move->next())
+        moves.push_back(move->code());
+    return moves;
+}
+
+void ChessManual::appendRootRemark(const wstring& remark)
+{
+    rootMove_->setRemark(rootMove_->remark().empty() ? remark : rootMove_->remark() + L'\n' + remark);
+}
+
+void ChessManual::addRootVariations(const vector<vector<MoveCode>>& lines, const vector<wstring>& remarks)
+{
+    auto __getSeatPair = [&](MoveCode move) {
+        int findex{ MoveList::fromIndex(move) }, tindex{ MoveList::toIndex(move) };
+        return board_->getSeatPair(findex / BOARDCOLNUM * 10 + findex % BOARDCOLNUM, tindex / BOARDCOLNUM * 10 + tindex % BOARDCOLNUM);
+    };
+    backTo(rootMove_);
+    for (size_t index = 0; index < lines.size(); ++index) {
+        if (lines[index].empty())
+            continue;
+        wstring remark{ index < remarks.size() ? remarks[index] : wstring{} };
+        SMove move{ rootMove_->next() }, lastMove{};
+        for (; move && move->code() != lines[index][0]; move = move->other())
+            lastMove = move;
+        if (move) {
+            move->setRemark(move->remark().empty() ? remark : move->remark() + L'\n' + remark);
+            continue;
+        }
+
+        move = lastMove ? lastMove->addOther(__getSeatPair(lines[index][0]), remark)
+                        : rootMove_->addNext(__getSeatPair(lines[index][0]), remark);
+        for (size_t i = 1; i < lines[index].size(); ++i)
+            move = move->addNext(__getSeatPair(lines[index][i]), L"");
+    }
+    __setMoveZhStrAndNums();
 }
 
 void ChessManual::read(const string& infilename)
@@ -370,10 +426,14 @@ void ChessManual::__setMoveZhStrAndNums()
             }
             move->setZhStr(board_->getZhStr(move->getSeat_pair()));
 
-            move->done();
+            __done(move);
+            Repetition repetition{ board_->getRepetition() };
+            move->setRepetition(repetition);
+            if (repetition.isRepeated && repetition.own != repetition.other)
+                ++banCount_;
             if (move->next())
                 __setZhStrAndNums(move->next());
-            move->undo();
+            __undo(move);
 
             if (move->other()) {
                 ++maxCol_;
@@ -381,11 +441,23 @@ void ChessManual::__setMoveZhStrAndNums()
             }
         };
 
-    movCount_ = remCount_ = remLenMax_ = maxRow_ = maxCol_ = 0;
+    movCount_ = remCount_ = remLenMax_ = maxRow_ = maxCol_ = banCount_ = 0;
     if (rootMove_->next())
         __setZhStrAndNums(rootMove_->next()); // 驱动函数
 }
 
+void ChessManual::__done(const SMove& move)
+{
+    board_->addHistory(move->code());
+    move->done();
+}
+
+void ChessManual::__undo(const SMove& move)
+{
+    move->undo();
+    board_->removeHistory();
+}
+
 void ChessManual::__setFENplusFromFEN(const wstring& FEN, PieceColor color)
 {
     info_[FENKey] = FENToFENplus(FEN, color);
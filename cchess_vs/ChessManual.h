@@ -28,6 +28,9 @@ private:
         const SMove& next() const { return next_; }
         const SMove& other() const { return other_; }
         const SMove prev() const { return prev_.lock(); }
+        MoveCode code() const;
+        // 本着之后局面循环的判断结果（读入棋谱时设置）
+        const Repetition& repetition() const { return repetition_; }
 
         SMove& addNext();
         SMove& addOther(); 
@@ -41,6 +44,7 @@ private:
             }
         void setPrev(const weak_ptr<Move>& prev) { prev_ = prev; }
         void setZhStr(const wstring& zhStr) { zhStr_ = zhStr; }
+        void setRepetition(const Repetition& repetition) { repetition_ = repetition; }
 
         vector<SMove> getPrevMoves();
         void done();
@@ -67,6 +71,7 @@ private:
         wstring zhStr_{}; // 中文着法描述
         SPiece eatPie_{};
         SMove next_{}, other_{};
+        Repetition repetition_{ false, RepeatKind::IDLE, RepeatKind::IDLE };
 
         int nextNo_{ 0 }, otherNo_{ 0 }, CC_ColNo_{ 0 }; // CC_ColNo_:图中列位置（需在ChessManual::setMoves确定）
     };
@@ -92,9 +97,19 @@ public:
 
     void changeSide(ChangeType ct);
 
+    // 起始局面的棋子字符串、主线的着法（供杀着检验等）
+    const wstring getStartPieceChars() const;
+    const vector<MoveCode> getMainMoves() const;
+    // 在起始局面的注解之后追加一段
+    void appendRootRemark(const wstring& remark);
+    // 起始局面加入各变例（如多变例搜索的结果）：首着已有的只追加注解，否则加为首着的变着(other)；remarks为各变例首着的注解
+    void addRootVariations(const vector<vector<MoveCode>>& lines, const vector<wstring>& remarks);
+
     int getMovCount() const { return movCount_; }
     int getRemCount() const { return remCount_; }
     int getRemLenMax() const { return remLenMax_; }
+    // 违例循环（长将、长捉）的着法数量
+    int getBanCount() const { return banCount_; }
     int getMaxRow() const { return maxRow_; }
     int getMaxCol() const { return maxCol_; }
 
@@ -107,6 +122,9 @@ private:
     void __setMoveFromRowcol(const SMove& move, int frowcol, int trowcol, const wstring& remark) const;
     void __setMoveFromStr(const SMove& move, const wstring& str, RecFormat fmt, const wstring& remark) const;
     void __setMoveZhStrAndNums();
+    // 走子、退回并维护棋盘的局面历史（供循环判断）
+    void __done(const SMove& move);
+    void __undo(const SMove& move);
 
     const wstring __moveInfo() const;
 
@@ -130,7 +148,7 @@ private:
     map<wstring, wstring> info_;
     shared_ptr<Board> board_;
     SMove rootMove_, currentMove_;
-    int movCount_{ 0 }, remCount_{ 0 }, remLenMax_{ 0 }, maxRow_{ 0 }, maxCol_{ 0 };
+    int movCount_{ 0 }, remCount_{ 0 }, remLenMax_{ 0 }, maxRow_{ 0 }, maxCol_{ 0 }, banCount_{ 0 };
 };
  
 void transDir(const string& dirfrom, const RecFormat fmt);
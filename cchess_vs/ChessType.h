@@ -3,8 +3,11 @@
 #define CHESSTYPE_H
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cctype>
+#include <chrono>
+#include <climits>
 #include <cmath>
 #include <direct.h>
 #include <fstream>
@@ -14,10 +17,14 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <random>
 #include <regex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 namespace PieceSpace {
@@ -30,21 +37,62 @@ namespace SeatSpace {
 class Seat;
 class Seats;
 class SeatManager;
+struct CheckInfo;
+class MoveList;
+class PieceLists;
+}
+
+namespace BitBoardSpace {
+class BitBoard;
+class BitBoards;
+}
+
+namespace MailboxSpace {
+class Mailbox;
+}
+
+namespace EvaluateSpace {
+class Evaluation;
+}
+
+namespace NnueSpace {
+class Accumulator;
 }
 
 namespace BoardSpace {
 class Board;
 }
 
+namespace SearchSpace {
+class Search;
+}
+
+namespace TablebaseSpace {
+class Tablebase;
+class TablebaseManager;
+}
+
 namespace ChessManualSpace {
 class ChessManual;
 }
 
+namespace MateSpace {
+class MateSolver;
+class MateManager;
+}
+
 using namespace std;
 using namespace PieceSpace;
 using namespace SeatSpace;
+using namespace BitBoardSpace;
+using namespace MailboxSpace;
+using namespace EvaluateSpace;
+using namespace NnueSpace;
 using namespace BoardSpace;
+using namespace SearchSpace;
+using namespace TablebaseSpace;
 using namespace ChessManualSpace;
+using namespace MateSpace;
 
 enum class PieceColor {
     RED,
@@ -67,6 +115,19 @@ enum class ChangeType {
     SYMMETRY
 };
 
+// 局面循环时一方着法的类别：闲着、长捉（连续捉同一棋子，可间以将军）、长将，违例程度依次加重
+enum class RepeatKind {
+    IDLE,
+    CHASE,
+    CHECK
+};
+
+// 循环判断的结果：isRepeated为假时无循环，否则为循环中走子方、对方着法的类别（较重的一方判负，相同则为和棋）
+struct Repetition {
+    bool isRepeated;
+    RepeatKind own, other;
+};
+
 enum class RecFormat {
     XQF,
     BIN,
@@ -87,6 +148,10 @@ typedef pair<pair<int, int>, pair<int, int>> PRowCol_pair;
 typedef vector<RowCol_pair> RowCol_pair_vector;
 typedef vector<PRowCol_pair> PRowCol_pair_vector;
 
+typedef unsigned long long ZobristKey;
+// 着法编码：低7位为起点位置序号，其上7位为终点位置序号
+typedef unsigned short MoveCode;
+
 typedef shared_ptr<BoardSpace::Board> SBoard;
 typedef shared_ptr<ChessManualSpace::ChessManual> SChessManual;
 
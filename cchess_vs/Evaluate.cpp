@@ -0,0 +1,189 @@
+﻿#include "Evaluate.h"
+
+namespace EvaluateSpace {
+
+// 缺省评估参数
+static constexpr EvalParams DefaultParams{
+    { 0, 120, 120, 270, 600, 285, 30 },
+    {
+        { // 将帅
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0, -10, -12, -10,   0,   0,   0,
+              0,   0,   0,  -8,  -6,  -8,   0,   0,   0,
+              0,   0,   0,   2,  10,   2,   0,   0,   0
+        },
+        { // 士仕
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,  -2,   0,  -2,   0,   0,   0,
+              0,   0,   0,   0,   4,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0
+        },
+        { // 象相
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,  -2,   0,   0,   0,  -2,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+             -2,   0,   0,   0,   4,   0,   0,   0,  -2,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0
+        },
+        { // 马
+              2,   4,   6,   6,   4,   6,   6,   4,   2,
+              4,   8,  16,  12,   6,  12,  16,   8,   4,
+              6,  14,  16,  20,  16,  20,  16,  14,   6,
+              6,  12,  18,  20,  20,  20,  18,  12,   6,
+              4,  10,  14,  18,  18,  18,  14,  10,   4,
+              2,   8,  12,  14,  14,  14,  12,   8,   2,
+              0,   6,  10,  10,  12,  10,  10,   6,   0,
+              0,   2,   6,   6,   4,   6,   6,   2,   0,
+             -2,   0,   2,   4, -10,   4,   2,   0,  -2,
+             -4,  -4,   0,  -2,   0,  -2,   0,  -4,  -4
+        },
+        { // 车
+             12,  14,  12,  18,  20,  18,  12,  14,  12,
+             12,  18,  16,  22,  24,  22,  16,  18,  12,
+             10,  12,  12,  18,  18,  18,  12,  12,  10,
+             10,  14,  14,  18,  18,  18,  14,  14,  10,
+             10,  16,  16,  18,  18,  18,  16,  16,  10,
+              8,  14,  14,  16,  16,  16,  14,  14,   8,
+              4,  10,   8,  14,  14,  14,   8,  10,   4,
+             -2,   8,   4,  12,  10,  12,   4,   8,  -2,
+              2,   8,   6,  12,   0,  12,   6,   8,   2,
+             -6,   6,   4,  12,   0,  12,   4,   6,  -6
+        },
+        { // 炮
+              6,   4,   0, -10, -12, -10,   0,   4,   6,
+              2,   2,   0,  -4, -14,  -4,   0,   2,   2,
+              2,   2,   0, -10,  -8, -10,   0,   2,   2,
+              0,   0,  -2,   4,  10,   4,  -2,   0,   0,
+              0,   0,   0,   2,   8,   2,   0,   0,   0,
+             -2,   0,   4,   2,   6,   2,   4,   0,  -2,
+              0,   0,   0,   2,   4,   2,   0,   0,   0,
+              4,   0,   8,   6,  10,   6,   8,   0,   4,
+              0,   2,   4,   6,   6,   6,   4,   2,   0,
+              0,   0,   2,   6,   6,   6,   2,   0,   0
+        },
+        { // 兵卒
+              0,   2,   4,   6,   8,   6,   4,   2,   0,
+             10,  20,  30,  40,  50,  40,  30,  20,  10,
+             10,  18,  24,  30,  36,  30,  24,  18,  10,
+              8,  14,  18,  22,  24,  22,  18,  14,   8,
+              6,  10,  12,  14,  16,  14,  12,  10,   6,
+              0,   0,   2,   0,   4,   0,   2,   0,   0,
+              0,   0,  -2,   0,   2,   0,  -2,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0,
+              0,   0,   0,   0,   0,   0,   0,   0,   0
+        }
+    }
+};
+
+static const char* const KindNames[7]{ "king", "advisor", "bishop", "knight", "rook", "cannon", "pawn" };
+
+// 位置序号在位置价值表中的序号（表按行由第9行排至第0行），反之亦然
+static constexpr int getTableIndex(int index)
+{
+    return (BOARDROWNUM - 1 - index / BOARDCOLNUM) * BOARDCOLNUM + index % BOARDCOLNUM;
+}
+
+/* ===== EvalManager start. ===== */
+bool EvalManager::load(const string& fileName)
+{
+    ifstream ifs(fileName);
+    if (!ifs)
+        return false;
+    EvalParams params{ params_ };
+    string token{};
+    while (ifs >> token) {
+        if (token[0] == '#') {
+            getline(ifs, token);
+            continue;
+        }
+        if (token == "values") {
+            for (int& value : params.kindValues)
+                if (!(ifs >> value))
+                    return false;
+            continue;
+        }
+        auto name = find_if(begin(KindNames), end(KindNames), [&](const char* kindName) { return token == kindName; });
+        if (name == end(KindNames))
+            return false;
+        for (int& value : params.positionValues[name - begin(KindNames)])
+            if (!(ifs >> value))
+                return false;
+    }
+    params_ = params;
+    values_ = __getValues(params_);
+    return true;
+}
+
+bool EvalManager::write(const string& fileName)
+{
+    ofstream ofs(fileName);
+    if (!ofs)
+        return false;
+    ofs << "# kind values: king advisor bishop knight rook cannon pawn\nvalues";
+    for (int value : params_.kindValues)
+        ofs << ' ' << value;
+    ofs << "\n# position values: row 9 (opponent's back rank) to row 0 (own back rank)\n";
+    for (int kind = 0; kind < 7; ++kind) {
+        ofs << KindNames[kind] << '\n';
+        for (int i = 0; i < SEATNUM; ++i)
+            ofs << setw(4) << params_.positionValues[kind][i] << (i % BOARDCOLNUM == BOARDCOLNUM - 1 ? "\n" : "");
+    }
+    return static_cast<bool>(ofs);
+}
+
+constexpr EvalValues EvalManager::__getValues(const EvalParams& params)
+{
+    EvalValues values{};
+    for (int kind = 0; kind < 7; ++kind)
+        for (int index = 0; index < SEATNUM; ++index) {
+            int kindValue{ params.kindValues[kind] };
+            // 顶方的位置价值取旋转180度后的位置
+            values.values[1][kind][index] = kindValue + params.positionValues[kind][getTableIndex(index)];
+            values.values[0][kind][index] = kindValue + params.positionValues[kind][getTableIndex(SEATNUM - 1 - index)];
+        }
+    return values;
+}
+
+EvalParams EvalManager::params_ = DefaultParams;
+EvalValues EvalManager::values_ = EvalManager::__getValues(DefaultParams);
+/* ===== EvalManager end. ===== */
+
+/* ===== Evaluation start. ===== */
+void Evaluation::put(PieceColor color, PieceKind kind, int index)
+{
+    int c{ static_cast<int>(color) };
+    values_[c][0] += EvalManager::getValue(false, kind, index);
+    values_[c][1] += EvalManager::getValue(true, kind, index);
+}
+
+void Evaluation::remove(PieceColor color, PieceKind kind, int index)
+{
+    int c{ static_cast<int>(color) };
+    values_[c][0] -= EvalManager::getValue(false, kind, index);
+    values_[c][1] -= EvalManager::getValue(true, kind, index);
+}
+
+void Evaluation::clear()
+{
+    *this = Evaluation{};
+}
+/* ===== Evaluation end. ===== */
+}
@@ -0,0 +1,61 @@
+﻿//#pragma once
+#ifndef EVALUATE_H
+#define EVALUATE_H
+
+#include "ChessType.h"
+
+namespace EvaluateSpace {
+
+// 评估参数：各种棋子的子力价值，及底方视角的位置价值（按棋盘由对方底线第9行至本方底线第0行排列，便于对照）
+struct EvalParams {
+    int kindValues[7];
+    int positionValues[7][SEATNUM];
+};
+
+// 由评估参数生成的价值表：按是否底方、种类、位置序号
+struct EvalValues {
+    int values[2][7][SEATNUM];
+};
+
+// 评估参数管理类：缺省参数编译期给出，可由文本文件载入以便调整而无须重新编译
+// 文件格式：#开头为注释；values后接7个子力价值（将士象马车炮兵）；
+// king、advisor、bishop、knight、rook、cannon、pawn后各接90个位置价值（排列同EvalParams）
+// 载入参数后须重新设置棋盘的棋子（增量评估值据此重新累计），不可在搜索进行中载入
+class EvalManager {
+
+public:
+    // 某方（isBottom为其是否底方）某种棋子在index位置的价值：子力价值加位置价值（顶方按旋转后的位置取值）
+    static int getValue(bool isBottom, PieceKind kind, int index)
+    {
+        return values_.values[isBottom][static_cast<int>(kind)][index];
+    }
+
+    static const EvalParams& params() { return params_; }
+    // 载入成功返回true；文件不能打开或格式有误则返回false，参数不变
+    static bool load(const string& fileName);
+    static bool write(const string& fileName);
+
+private:
+    // 缺省参数及其价值表均在编译期生成，不依赖静态对象的初始化顺序
+    static EvalParams params_;
+    static EvalValues values_;
+
+    static constexpr EvalValues __getValues(const EvalParams& params);
+};
+
+// 增量评估值：随走子累计双方子力及位置价值，底方、顶方两种视角分别累计，评估时据实际所在方选用
+class Evaluation {
+
+public:
+    int value(PieceColor color, bool isBottom) const { return values_[static_cast<int>(color)][isBottom]; }
+
+    void put(PieceColor color, PieceKind kind, int index);
+    void remove(PieceColor color, PieceKind kind, int index);
+    void clear();
+
+private:
+    int values_[2][2]{};
+};
+}
+
+#endif
@@ -0,0 +1,239 @@
+﻿#include "Mailbox.h"
+#include "Piece.h"
+#include "Seat.h"
+
+namespace MailboxSpace {
+
+// 各方向偏移量：左、右、下、上
+static constexpr int LineOffsets[4]{ -1, 1, -Mailbox::WIDTH, Mailbox::WIDTH };
+// 士、象（象眼为其一半）的偏移量
+static constexpr int AdvisorOffsets[4]{ -Mailbox::WIDTH - 1, -Mailbox::WIDTH + 1, Mailbox::WIDTH - 1, Mailbox::WIDTH + 1 };
+// 马的偏移量及对应马腿的偏移量
+static constexpr int KnightOffsets[8][2]{
+    { 2 * Mailbox::WIDTH - 1, Mailbox::WIDTH }, { 2 * Mailbox::WIDTH + 1, Mailbox::WIDTH },
+    { -2 * Mailbox::WIDTH - 1, -Mailbox::WIDTH }, { -2 * Mailbox::WIDTH + 1, -Mailbox::WIDTH },
+    { Mailbox::WIDTH + 2, 1 }, { -Mailbox::WIDTH + 2, 1 },
+    { Mailbox::WIDTH - 2, -1 }, { -Mailbox::WIDTH - 2, -1 }
+};
+
+/* ===== Mailbox start. ===== */
+Mailbox::Mailbox()
+{
+    clear();
+}
+
+void Mailbox::put(PieceColor color, PieceKind kind, int index)
+{
+    int square{ getSquare(index) };
+    squares_[square] = getCode(color, kind);
+    if (kind == PieceKind::KING)
+        kingSquares_[static_cast<int>(color)] = square;
+}
+
+void Mailbox::remove(int index)
+{
+    squares_[getSquare(index)] = EMPTY;
+}
+
+void Mailbox::clear()
+{
+    for (int square = 0; square < SQUARENUM; ++square)
+        squares_[square] = squareFlags_.flags[square] ? EMPTY : OFFBOARD;
+    kingSquares_[0] = kingSquares_[1] = 0;
+}
+
+unsigned char Mailbox::movTo(int fsquare, int tsquare)
+{
+    unsigned char code{ squares_[fsquare] }, eatCode{ squares_[tsquare] };
+    squares_[tsquare] = code;
+    squares_[fsquare] = EMPTY;
+    if (getKind(code) == PieceKind::KING)
+        kingSquares_[static_cast<int>(getColor(code))] = tsquare;
+    return eatCode;
+}
+
+void Mailbox::movBack(int fsquare, int tsquare, unsigned char eatCode)
+{
+    unsigned char code{ squares_[tsquare] };
+    squares_[fsquare] = code;
+    squares_[tsquare] = eatCode;
+    if (getKind(code) == PieceKind::KING)
+        kingSquares_[static_cast<int>(getColor(code))] = fsquare;
+}
+
+void Mailbox::getMoves(MoveList& moves, PieceColor color, bool isBottom, bool isCapture) const
+{
+    if (isBottom)
+        __getMoves<true>(moves, color, isCapture);
+    else
+        __getMoves<false>(moves, color, isCapture);
+}
+
+bool Mailbox::isAttacked(PieceColor color, bool isBottom, int square) const
+{
+    return isBottom ? __isAttacked<true>(color, square) : __isAttacked<false>(color, square);
+}
+
+bool Mailbox::isKilled(PieceColor color, bool isBottom) const
+{
+    int kingSquare{ kingSquares_[static_cast<int>(color)] };
+    PieceColor othColor{ PieceManager::getOtherColor(color) };
+    return isBottom ? __isAttacked<false>(othColor, kingSquare) : __isAttacked<true>(othColor, kingSquare);
+}
+
+long long Mailbox::perft(PieceColor color, bool isBottom, int depth)
+{
+    return isBottom ? __perft<true>(color, depth) : __perft<false>(color, depth);
+}
+
+const wstring Mailbox::toString() const
+{
+    wostringstream wos{};
+    for (int row = BOARDROWNUM - 1; row >= 0; --row) {
+        for (int col = 0; col < BOARDCOLNUM; ++col)
+            wos << setw(3) << static_cast<int>(squares_[getSquare(row * BOARDCOLNUM + col)]);
+        wos << L'\n';
+    }
+    return wos.str();
+}
+
+void Mailbox::__addMoves(MoveList& moves, int fsquare, int tsquare, PieceColor color, bool isCapture) const
+{
+    unsigned char code{ squares_[tsquare] };
+    if (isCapture ? (code != EMPTY && code != OFFBOARD && getColor(code) != color) : code == EMPTY)
+        moves.add(getIndex(fsquare), getIndex(tsquare));
+}
+
+template <bool IsBottom>
+void Mailbox::__getMoves(MoveList& moves, PieceColor color, bool isCapture) const
+{
+    constexpr unsigned char palace{ IsBottom ? BOTTOMPALACE : TOPPALACE }, side{ IsBottom ? BOTTOMSIDE : TOPSIDE };
+    constexpr int forward{ IsBottom ? WIDTH : -WIDTH };
+    for (int index = 0; index < SEATNUM; ++index) {
+        int fsquare{ getSquare(index) };
+        unsigned char code{ squares_[fsquare] };
+        if (code == EMPTY || getColor(code) != color)
+            continue;
+        switch (getKind(code)) {
+        case PieceKind::KING:
+            for (int offset : LineOffsets)
+                if (squareFlags_.flags[fsquare + offset] & palace)
+                    __addMoves(moves, fsquare, fsquare + offset, color, isCapture);
+            break;
+        case PieceKind::ADVISOR:
+            for (int offset : AdvisorOffsets)
+                if (squareFlags_.flags[fsquare + offset] & palace)
+                    __addMoves(moves, fsquare, fsquare + offset, color, isCapture);
+            break;
+        case PieceKind::BISHOP:
+            for (int offset : AdvisorOffsets)
+                if ((squareFlags_.flags[fsquare + 2 * offset] & side) && squares_[fsquare + offset] == EMPTY)
+                    __addMoves(moves, fsquare, fsquare + 2 * offset, color, isCapture);
+            break;
+        case PieceKind::KNIGHT:
+            for (auto& offsets : KnightOffsets)
+                if (squares_[fsquare + offsets[1]] == EMPTY)
+                    __addMoves(moves, fsquare, fsquare + offsets[0], color, isCapture);
+            break;
+        case PieceKind::ROOK:
+            for (int offset : LineOffsets) {
+                int tsquare{ fsquare + offset };
+                for (; squares_[tsquare] == EMPTY; tsquare += offset)
+                    __addMoves(moves, fsquare, tsquare, color, isCapture);
+                __addMoves(moves, fsquare, tsquare, color, isCapture);
+            }
+            break;
+        case PieceKind::CANNON:
+            for (int offset : LineOffsets) {
+                int tsquare{ fsquare + offset };
+                for (; squares_[tsquare] == EMPTY; tsquare += offset)
+                    __addMoves(moves, fsquare, tsquare, color, isCapture);
+                if (squares_[tsquare] == OFFBOARD || !isCapture)
+                    continue;
+                // 隔一个棋子（炮架）之后的第一个棋子
+                for (tsquare += offset; squares_[tsquare] == EMPTY; tsquare += offset)
+                    ;
+                __addMoves(moves, fsquare, tsquare, color, isCapture);
+            }
+            break;
+        case PieceKind::PAWN:
+            __addMoves(moves, fsquare, fsquare + forward, color, isCapture);
+            if (!(squareFlags_.flags[fsquare] & side)) { // 已过河
+                __addMoves(moves, fsquare, fsquare - 1, color, isCapture);
+                __addMoves(moves, fsquare, fsquare + 1, color, isCapture);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+template <bool IsBottom>
+bool Mailbox::__isAttacked(PieceColor color, int square) const
+{
+    unsigned char rook{ getCode(color, PieceKind::ROOK) }, cannon{ getCode(color, PieceKind::CANNON) },
+        knight{ getCode(color, PieceKind::KNIGHT) }, king{ getCode(color, PieceKind::KING) },
+        pawn{ getCode(color, PieceKind::PAWN) };
+    // 车（纵线上还有将帅对面）：每个方向第一个棋子；炮：每个方向隔一个棋子之后的第一个棋子
+    for (int line = 0; line < 4; ++line) {
+        int offset{ LineOffsets[line] }, tsquare{ square + offset };
+        while (squares_[tsquare] == EMPTY)
+            tsquare += offset;
+        if (squares_[tsquare] == OFFBOARD)
+            continue;
+        if (squares_[tsquare] == rook || (line >= 2 && squares_[tsquare] == king))
+            return true;
+        for (tsquare += offset; squares_[tsquare] == EMPTY; tsquare += offset)
+            ;
+        if (squares_[tsquare] == cannon)
+            return true;
+    }
+    // 马：由马所在位置(square - 偏移量)看，马腿为其相邻位置
+    for (auto& offsets : KnightOffsets) {
+        int fsquare{ square - offsets[0] };
+        if (squares_[fsquare] == knight && squares_[fsquare + offsets[1]] == EMPTY)
+            return true;
+    }
+    // 兵：后方（兵的前进方向反向），或已过河时的左右
+    if (squares_[square - (IsBottom ? WIDTH : -WIDTH)] == pawn)
+        return true;
+    return !(squareFlags_.flags[square] & (IsBottom ? BOTTOMSIDE : TOPSIDE))
+        && (squares_[square - 1] == pawn || squares_[square + 1] == pawn);
+}
+
+template <bool IsBottom>
+long long Mailbox::__perft(PieceColor color, int depth)
+{
+    if (depth <= 0)
+        return 1;
+    long long nodes{ 0 };
+    PieceColor othColor{ PieceManager::getOtherColor(color) };
+    MoveList moves{};
+    __getMoves<IsBottom>(moves, color, true);
+    __getMoves<IsBottom>(moves, color, false);
+    for (auto move : moves) {
+        int fsquare{ getSquare(MoveList::fromIndex(move)) }, tsquare{ getSquare(MoveList::toIndex(move)) };
+        unsigned char eatCode{ movTo(fsquare, tsquare) };
+        if (!__isAttacked<!IsBottom>(othColor, kingSquares_[static_cast<int>(color)]))
+            nodes += __perft<!IsBottom>(othColor, depth - 1);
+        movBack(fsquare, tsquare, eatCode);
+    }
+    return nodes;
+}
+
+constexpr SquareFlags Mailbox::__getSquareFlags()
+{
+    SquareFlags squareFlags{};
+    for (int index = 0; index < SEATNUM; ++index) {
+        int row{ index / BOARDCOLNUM }, col{ index % BOARDCOLNUM };
+        bool isPalace{ col >= 3 && col <= 5 };
+        squareFlags.flags[getSquare(index)] = (row <= 4 ? BOTTOMSIDE : TOPSIDE)
+            | (isPalace && row <= 2 ? BOTTOMPALACE : 0) | (isPalace && row >= 7 ? TOPPALACE : 0);
+    }
+    return squareFlags;
+}
+
+const SquareFlags Mailbox::squareFlags_ = Mailbox::__getSquareFlags();
+/* ===== Mailbox end. ===== */
+}
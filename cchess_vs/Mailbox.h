@@ -0,0 +1,85 @@
+﻿//#pragma once
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include "ChessType.h"
+
+namespace MailboxSpace {
+
+// 信箱各格的位置属性：标志位均为0的为哨兵格
+enum SquareFlag : unsigned char {
+    BOTTOMSIDE = 0x01,
+    TOPSIDE = 0x02,
+    BOTTOMPALACE = 0x04,
+    TOPPALACE = 0x08
+};
+
+struct SquareFlags {
+    unsigned char flags[256];
+};
+
+// 填充信箱棋盘：16x16字节，棋盘(10行9列)四周各留3格哨兵，马、象、车炮越界均落在哨兵上而无须范围判断
+// 每格一个字节：0为空，0xFF为哨兵，其余为棋子代码（颜色 << 3 | (种类 + 1)）
+class Mailbox {
+
+public:
+    static constexpr int SQUARENUM{ sizeof(SquareFlags::flags) }, WIDTH{ 16 }, PADNUM{ 3 };
+    static constexpr unsigned char EMPTY{ 0x00 }, OFFBOARD{ 0xFF };
+
+    static constexpr int getSquare(int index)
+    {
+        return (index / BOARDCOLNUM + PADNUM) * WIDTH + index % BOARDCOLNUM + PADNUM;
+    }
+    static constexpr int getIndex(int square)
+    {
+        return (square / WIDTH - PADNUM) * BOARDCOLNUM + square % WIDTH - PADNUM;
+    }
+    static constexpr unsigned char getCode(PieceColor color, PieceKind kind)
+    {
+        return static_cast<unsigned char>(static_cast<int>(color) << 3 | (static_cast<int>(kind) + 1));
+    }
+    static constexpr PieceColor getColor(unsigned char code) { return static_cast<PieceColor>(code >> 3); }
+    static constexpr PieceKind getKind(unsigned char code) { return static_cast<PieceKind>((code & 7) - 1); }
+
+    Mailbox();
+
+    unsigned char code(int square) const { return squares_[square]; }
+
+    void put(PieceColor color, PieceKind kind, int index);
+    void remove(int index);
+    void clear();
+
+    // 走子：返回被吃棋子代码（EMPTY为未吃子）；退回时放回该代码
+    unsigned char movTo(int fsquare, int tsquare);
+    void movBack(int fsquare, int tsquare, unsigned char eatCode);
+
+    // color方（isBottom为其是否底方）全部棋子的吃子或不吃子着法（位置序号），追加至moves（未排除被将军的情况）
+    void getMoves(MoveList& moves, PieceColor color, bool isBottom, bool isCapture) const;
+    // color方（isBottom为其是否底方）的车马炮兵、将（对面）是否可攻击square位置
+    bool isAttacked(PieceColor color, bool isBottom, int square) const;
+    bool isKilled(PieceColor color, bool isBottom) const;
+
+    // 走子生成器计数测试：color方（isBottom为其是否底方）先走，深度depth的叶结点数量
+    long long perft(PieceColor color, bool isBottom, int depth);
+
+    const wstring toString() const;
+
+private:
+    unsigned char squares_[SQUARENUM];
+    int kingSquares_[2]{}; // 双方将帅所在位置
+
+    void __addMoves(MoveList& moves, int fsquare, int tsquare, PieceColor color, bool isCapture) const;
+    // 按是否底方(IsBottom)特化的实例，公有接口据isBottom选用其一
+    template <bool IsBottom>
+    void __getMoves(MoveList& moves, PieceColor color, bool isCapture) const;
+    template <bool IsBottom>
+    bool __isAttacked(PieceColor color, int square) const;
+    template <bool IsBottom>
+    long long __perft(PieceColor color, int depth);
+
+    static constexpr SquareFlags __getSquareFlags();
+    static const SquareFlags squareFlags_;
+};
+}
+
+#endif
@@ -0,0 +1,287 @@
+﻿#include "Mate.h"
+#include "ChessManual.h"
+#include "Piece.h"
+#include "Seat.h"
+#include "Tools.h"
+
+namespace MateSpace {
+
+// 可读入的棋谱文件扩展名（同transDir）
+static const string ManualExtensions{ ".xqf.pgn_iccs.pgn_zh.pgn_cc.bin.json" };
+
+static const char* getResultName(MateResult result)
+{
+    static const char* names[]{ "shortest", "longer", "notcheck", "notmate", "notforced", "error" };
+    return names[static_cast<int>(result)];
+}
+
+/* ===== MateSolver start. ===== */
+MateSolver::MateSolver(const Board& board, PieceColor color)
+    : board_{ board.getPieceChars() }
+    , color_{ color }
+{
+}
+
+int MateSolver::solve(int maxSteps, vector<MoveCode>* pv)
+{
+    for (int steps = 1; steps <= maxSteps; ++steps)
+        if (__attack(color_, steps)) {
+            if (pv) {
+                pv->clear();
+                __getPV(color_, steps, *pv);
+            }
+            return steps;
+        }
+    return 0;
+}
+
+bool MateSolver::__attack(PieceColor color, int steps)
+{
+    ++nodes_;
+    ZobristKey key{ board_.key() };
+    auto provenIter = proven_.find(key);
+    if (provenIter != proven_.end() && provenIter->second <= steps)
+        return true;
+    auto disprovenIter = disproven_.find(key);
+    if (disprovenIter != disproven_.end() && disprovenIter->second >= steps)
+        return false;
+
+    PieceColor othColor{ PieceManager::getOtherColor(color) };
+    MoveList moves{};
+    __getCheckMoves(color, moves);
+    bool isMate{ false };
+    for (auto move : moves) {
+        auto eatPiece = board_.movTo(move);
+        isMate = __defend(othColor, steps);
+        board_.movBack(move, eatPiece);
+        if (isMate)
+            break;
+    }
+    if (isMate)
+        proven_[key] = steps;
+    else
+        disproven_[key] = steps;
+    return isMate;
+}
+
+bool MateSolver::__defend(PieceColor color, int steps)
+{
+    ++nodes_;
+    if (steps <= 1) // 攻方已无着可走：须已被将死或困毙
+        return board_.isDied(color);
+
+    PieceColor othColor{ PieceManager::getOtherColor(color) };
+    MoveList moves{};
+    board_.getCanMoves(moves, color, true);
+    board_.getCanMoves(moves, color, false);
+    for (auto move : moves) {
+        auto eatPiece = board_.movTo(move);
+        bool isMate{ __attack(othColor, steps - 1) };
+        board_.movBack(move, eatPiece);
+        if (!isMate)
+            return false;
+    }
+    return true; // 无应着即被将死或困毙
+}
+
+void MateSolver::__getCheckMoves(PieceColor color, MoveList& moves)
+{
+    PieceColor othColor{ PieceManager::getOtherColor(color) };
+    MoveList allMoves{};
+    board_.getCanMoves(allMoves, color, true);
+    board_.getCanMoves(allMoves, color, false);
+    pair<int, MoveCode> checks[MoveList::MaxNum]{};
+    int checkCount{ 0 };
+    for (auto move : allMoves) {
+        auto eatPiece = board_.movTo(move);
+        if (board_.isKilled(othColor)) {
+            MoveList replies{};
+            board_.getCanMoves(replies, othColor, true);
+            board_.getCanMoves(replies, othColor, false);
+            checks[checkCount++] = make_pair(replies.size(), move);
+        }
+        board_.movBack(move, eatPiece);
+    }
+    stable_sort(checks, checks + checkCount,
+        [](const pair<int, MoveCode>& a, const pair<int, MoveCode>& b) { return a.first < b.first; });
+    for (int i = 0; i < checkCount; ++i)
+        moves.add(MoveList::fromIndex(checks[i].second), MoveList::toIndex(checks[i].second));
+}
+
+void MateSolver::__getPV(PieceColor color, int steps, vector<MoveCode>& pv)
+{
+    PieceColor othColor{ PieceManager::getOtherColor(color) };
+    MoveList moves{};
+    __getCheckMoves(color, moves);
+    for (auto move : moves) {
+        auto eatPiece = board_.movTo(move);
+        if (__defend(othColor, steps)) {
+            pv.push_back(move);
+            // 守方取攻方所需步数最多的应着
+            MoveList replies{};
+            board_.getCanMoves(replies, othColor, true);
+            board_.getCanMoves(replies, othColor, false);
+            MoveCode bestReply{ 0 };
+            int bestSteps{ 0 };
+            for (auto reply : replies) {
+                auto replyEatPiece = board_.movTo(reply);
+                int replySteps{ 1 };
+                while (replySteps < steps - 1 && !__attack(color, replySteps))
+                    ++replySteps;
+                board_.movBack(reply, replyEatPiece);
+                if (replySteps > bestSteps) {
+                    bestSteps = replySteps;
+                    bestReply = reply;
+                }
+            }
+            if (bestReply) {
+                pv.push_back(bestReply);
+                auto replyEatPiece = board_.movTo(bestReply);
+                __getPV(color, bestSteps, pv);
+                board_.movBack(bestReply, replyEatPiece);
+            }
+            board_.movBack(move, eatPiece);
+            return;
+        }
+        board_.movBack(move, eatPiece);
+    }
+}
+/* ===== MateSolver end. ===== */
+
+/* ===== MateManager start. ===== */
+const string MateManager::ReportFileName{ "mate_report.txt" };
+mutex MateManager::mutex_{};
+
+MateReport MateManager::checkManual(const string& fileName, int maxSteps)
+{
+    unique_ptr<ChessManual> manual{};
+    try {
+        lock_guard<mutex> lock{ mutex_ };
+        manual.reset(new ChessManual(fileName));
+    } catch (...) {
+        return MateReport{ fileName, MateResult::ERROR, 0, 0, {} };
+    }
+    return __checkManual(*manual, fileName, maxSteps);
+}
+
+vector<MateReport> MateManager::checkDir(const string& dirName, int maxSteps, int threadNum, bool isWriteRemark)
+{
+    vector<string> allFiles{}, files{};
+    Tools::getFiles(dirName, allFiles);
+    for (auto& fileName : allFiles)
+        if (fileName.rfind('.') != string::npos && ManualExtensions.find(Tools::getExtStr(fileName)) != string::npos)
+            files.push_back(fileName);
+
+    int fileNum = files.size();
+    vector<MateReport> reports(fileNum);
+    atomic<int> nextIndex{ 0 };
+    auto __worker = [&]() {
+        for (int index = nextIndex++; index < fileNum; index = nextIndex++) {
+            auto& fileName = files[index];
+            unique_ptr<ChessManual> manual{};
+            try {
+                lock_guard<mutex> lock{ mutex_ };
+                manual.reset(new ChessManual(fileName));
+            } catch (...) {
+                reports[index] = MateReport{ fileName, MateResult::ERROR, 0, 0, {} };
+                continue;
+            }
+            reports[index] = __checkManual(*manual, fileName, maxSteps);
+            // XQF格式不能写入，只列入报告
+            if (isWriteRemark && Tools::getExtStr(fileName) != ".xqf") {
+                lock_guard<mutex> lock{ mutex_ };
+                manual->appendRootRemark(getRemark(reports[index]));
+                manual->write(fileName);
+            }
+        }
+    };
+    vector<thread> threads{};
+    for (int i = 1; i < min(max(threadNum, 1), fileNum); ++i)
+        threads.emplace_back(__worker);
+    __worker(); // 本线程同样参与计算
+    for (auto& th : threads)
+        th.join();
+
+    // 报告：每个文件一行（文件名、结果、主线步数、最少步数、最短杀法），最后为各结果的数量
+    ofstream ofs(dirName + '/' + ReportFileName);
+    int counts[static_cast<int>(MateResult::ERROR) + 1]{};
+    for (auto& report : reports) {
+        ++counts[static_cast<int>(report.result)];
+        ofs << report.fileName << '\t' << getResultName(report.result) << '\t'
+            << report.mainSteps << '\t' << report.steps << '\t';
+        for (auto move : report.pv)
+            ofs << PieceManager::getMoveICCS(move) << ' ';
+        ofs << '\n';
+    }
+    ofs << "total " << fileNum;
+    for (int result = 0; result <= static_cast<int>(MateResult::ERROR); ++result)
+        ofs << ", " << getResultName(static_cast<MateResult>(result)) << ' ' << counts[result];
+    ofs << '\n';
+    return reports;
+}
+
+const wstring MateManager::getRemark(const MateReport& report)
+{
+    wostringstream wos{};
+    wos << L"杀着检验：";
+    switch (report.result) {
+    case MateResult::SHORTEST:
+        wos << L"主线为最短的" << report.steps << L"步连将杀";
+        break;
+    case MateResult::LONGER:
+        wos << L"主线" << report.mainSteps << L"步，最短为" << report.steps << L"步连将杀";
+        break;
+    case MateResult::NOTCHECK:
+    case MateResult::NOTMATE:
+        wos << (report.result == MateResult::NOTCHECK ? L"主线不是连将" : L"主线终局未将死");
+        if (report.steps)
+            wos << L"，最短为" << report.steps << L"步连将杀";
+        else
+            wos << L"，未找到连将杀";
+        break;
+    case MateResult::NOTFORCED:
+        wos << L"主线" << report.mainSteps << L"步杀法不成立";
+        break;
+    default:
+        wos << L"棋谱读入错误";
+        break;
+    }
+    return wos.str();
+}
+
+MateReport MateManager::__checkManual(const ChessManual& manual, const string& fileName, int maxSteps)
+{
+    MateReport report{ fileName, MateResult::NOTMATE, 0, 0, {} };
+    vector<MoveCode> moves{ manual.getMainMoves() };
+    Board board{ manual.getStartPieceChars() };
+    PieceColor color{ PieceColor::RED };
+    if (!moves.empty())
+        color = PieceManager::getColor(board.getPieceChars()[MoveList::fromIndex(moves[0])]);
+
+    // 重演主线：攻方每着须将军，终局须为攻方走后对方无着可走
+    PieceColor othColor{ PieceManager::getOtherColor(color) };
+    bool isAllCheck{ true };
+    for (size_t i = 0; i < moves.size(); ++i) {
+        board.movTo(moves[i]);
+        if (i % 2 == 0 && !board.isKilled(othColor))
+            isAllCheck = false;
+    }
+    report.mainSteps = (moves.size() + 1) / 2;
+    bool isMate{ moves.size() % 2 == 1 && board.isDied(othColor) };
+
+    // 主线为连将杀时只须在主线步数以内求解
+    if (isMate && isAllCheck)
+        maxSteps = report.mainSteps;
+    MateSolver solver{ Board{ manual.getStartPieceChars() }, color };
+    report.steps = solver.solve(maxSteps, &report.pv);
+    if (!isMate)
+        report.result = MateResult::NOTMATE;
+    else if (!isAllCheck)
+        report.result = MateResult::NOTCHECK;
+    else
+        report.result = report.steps == 0 ? MateResult::NOTFORCED
+                                          : (report.steps < report.mainSteps ? MateResult::LONGER : MateResult::SHORTEST);
+    return report;
+}
+/* ===== MateManager end. ===== */
+}
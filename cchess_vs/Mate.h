@@ -0,0 +1,79 @@
+﻿//#pragma once
+#ifndef MATE_H
+#define MATE_H
+
+#include "Board.h"
+#include "ChessType.h"
+
+namespace MateSpace {
+
+// 连将杀求解类：攻方只走将军的着法，守方走全部应将着法，以isKilled、isDied为终局判断
+// 按攻方步数迭代加深，找到的即为最少步数；已证明、已否定的局面（键值）存放于各自的表中
+class MateSolver {
+
+public:
+    // 棋盘、棋子对象不能共享，据棋子字符串新建棋盘副本
+    MateSolver(const Board& board, PieceColor color);
+
+    // color方maxSteps步（攻方着数）以内连将杀的最少步数，无杀则返回0；pv为双方的一个最短杀法（守方取最长的应着）
+    int solve(int maxSteps, vector<MoveCode>* pv = nullptr);
+    long long nodes() const { return nodes_; }
+
+private:
+    Board board_;
+    PieceColor color_;
+    long long nodes_{ 0 };
+    // 攻方局面：可杀的最少步数；不可杀的最多步数
+    unordered_map<ZobristKey, int> proven_{}, disproven_{};
+
+    // 攻方color走，steps步以内能否连将杀
+    bool __attack(PieceColor color, int steps);
+    // 守方color走（已被将军），攻方steps步以内能否连将杀
+    bool __defend(PieceColor color, int steps);
+    // color方的将军着法，按守方应着数量由少到多排列
+    void __getCheckMoves(PieceColor color, MoveList& moves);
+    void __getPV(PieceColor color, int steps, vector<MoveCode>& pv);
+};
+
+// 杀着棋谱的检验结果：主线为最短杀法、主线杀法较长、主线不是连将、主线终局未杀、主线杀法不成立（守方另有应着）、读入错误
+enum class MateResult {
+    SHORTEST,
+    LONGER,
+    NOTCHECK,
+    NOTMATE,
+    NOTFORCED,
+    ERROR
+};
+
+struct MateReport {
+    string fileName;
+    MateResult result;
+    int mainSteps; // 主线攻方着数
+    int steps; // 最少步数，0为未找到
+    vector<MoveCode> pv;
+};
+
+// 杀着棋谱检验：主线攻方（第一着的一方）须每着将军且终局将死对方，再求最少步数与主线对比
+class MateManager {
+
+public:
+    // 主线不是连将杀时，求解的最多步数
+    static constexpr int DefaultMaxSteps{ 9 };
+
+    static MateReport checkManual(const string& fileName, int maxSteps = DefaultMaxSteps);
+    // 检验目录（含子目录）下的全部棋谱文件，threadNum个线程各取一个文件；结果写入目录下的报告文件，
+    // isWriteRemark为真时另将结论追加至各棋谱起始局面的注解并按原格式写回
+    static vector<MateReport> checkDir(const string& dirName, int maxSteps = DefaultMaxSteps,
+        int threadNum = thread::hardware_concurrency(), bool isWriteRemark = false);
+
+    static const wstring getRemark(const MateReport& report);
+    static const string ReportFileName;
+
+private:
+    static mutex mutex_; // 棋谱读写（含字符转换）不可并行
+
+    static MateReport __checkManual(const ChessManual& manual, const string& fileName, int maxSteps);
+};
+}
+
+#endif
@@ -0,0 +1,315 @@
+﻿#include "Nnue.h"
+#include "Piece.h"
+#include "Seat.h"
+
+namespace NnueSpace {
+
+// 累加器加上adds各特征、减去subs各特征的第一层权重
+static void updateValues(short* values, const short* weights, const int* adds, int addNum, const int* subs, int subNum)
+{
+#if defined(NNUE_USE_AVX2)
+    for (int i = 0; i < NnueHiddenNum; i += 16) {
+        __m256i sum{ _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)) };
+        for (int a = 0; a < addNum; ++a)
+            sum = _mm256_add_epi16(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + adds[a] * NnueHiddenNum + i)));
+        for (int s = 0; s < subNum; ++s)
+            sum = _mm256_sub_epi16(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + subs[s] * NnueHiddenNum + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + i), sum);
+    }
+#elif defined(NNUE_USE_SSE2)
+    for (int i = 0; i < NnueHiddenNum; i += 8) {
+        __m128i sum{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)) };
+        for (int a = 0; a < addNum; ++a)
+            sum = _mm_add_epi16(sum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + adds[a] * NnueHiddenNum + i)));
+        for (int s = 0; s < subNum; ++s)
+            sum = _mm_sub_epi16(sum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + subs[s] * NnueHiddenNum + i)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(values + i), sum);
+    }
+#else
+    for (int a = 0; a < addNum; ++a)
+        for (int i = 0; i < NnueHiddenNum; ++i)
+            values[i] += weights[adds[a] * NnueHiddenNum + i];
+    for (int s = 0; s < subNum; ++s)
+        for (int i = 0; i < NnueHiddenNum; ++i)
+            values[i] -= weights[subs[s] * NnueHiddenNum + i];
+#endif
+}
+
+// 累加器截断至[0, 127]
+static void clipValues(const short* values, unsigned char* output)
+{
+#if defined(NNUE_USE_AVX2)
+    const __m256i zero{ _mm256_setzero_si256() };
+    for (int i = 0; i < NnueHiddenNum; i += 32) {
+        __m256i packed{ _mm256_packs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i + 16))) };
+        // 打包按128位分段交错，重排回原顺序
+        packed = _mm256_permute4x64_epi64(_mm256_max_epi8(packed, zero), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), packed);
+    }
+#elif defined(NNUE_USE_SSE2)
+    const __m128i zero{ _mm_setzero_si128() };
+    for (int i = 0; i < NnueHiddenNum; i += 16) {
+        __m128i lo{ _mm_max_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i)), zero) },
+            hi{ _mm_max_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i + 8)), zero) };
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), _mm_packs_epi16(lo, hi));
+    }
+#else
+    for (int i = 0; i < NnueHiddenNum; ++i)
+        output[i] = static_cast<unsigned char>(max(0, min(static_cast<int>(values[i]), 127)));
+#endif
+}
+
+// 无符号8位输入与有符号8位权重的点积（num为32的倍数，输入不超过127，乘积对之和不会饱和）
+static int dotProduct(const unsigned char* input, const signed char* weights, int num)
+{
+#if defined(NNUE_USE_AVX2)
+    __m256i sum{ _mm256_setzero_si256() };
+    const __m256i ones{ _mm256_set1_epi16(1) };
+    for (int i = 0; i < num; i += 32) {
+        __m256i product{ _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i))) };
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(product, ones));
+    }
+    __m128i sum128{ _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1)) };
+#elif defined(NNUE_USE_SSE2)
+    __m128i sum128{ _mm_setzero_si128() };
+    const __m128i zero{ _mm_setzero_si128() };
+    for (int i = 0; i < num; i += 16) {
+        __m128i in{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)) },
+            weight{ _mm_loadu_si128(reinterpret_cast<const __m128i*>(weights + i)) },
+            sign{ _mm_cmpgt_epi8(zero, weight) };
+        // 扩展为16位后相乘并两两相加
+        sum128 = _mm_add_epi32(sum128, _mm_madd_epi16(_mm_unpacklo_epi8(in, zero), _mm_unpacklo_epi8(weight, sign)));
+        sum128 = _mm_add_epi32(sum128, _mm_madd_epi16(_mm_unpackhi_epi8(in, zero), _mm_unpackhi_epi8(weight, sign)));
+    }
+#endif
+#if defined(NNUE_USE_AVX2) || defined(NNUE_USE_SSE2)
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0x4E));
+    sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0xB1));
+    return _mm_cvtsi128_si32(sum128);
+#else
+    int sum{ 0 };
+    for (int i = 0; i < num; ++i)
+        sum += input[i] * weights[i];
+    return sum;
+#endif
+}
+
+// 全连接层：输出右移6位并截断至[0, 127]
+static void denseLayer(const unsigned char* input, int inputNum, const signed char* weights, const int* biases,
+    unsigned char* output, int outputNum)
+{
+    for (int o = 0; o < outputNum; ++o) {
+        int value{ biases[o] + dotProduct(input, weights + o * inputNum, inputNum) };
+        output[o] = static_cast<unsigned char>(value < 0 ? 0 : min(value >> 6, 127));
+    }
+}
+
+// isBottom视角的己方颜色及将帅位置，无将帅则返回false
+static bool getKing(const PieceLists& pieceLists, bool isBottom, PieceColor& color, int& kingIndex)
+{
+    for (auto kingColor : { PieceColor::RED, PieceColor::BLACK }) {
+        int index{ pieceLists.kingIndex(kingColor) };
+        if (index >= 0 && (index < SEATNUM / 2) == isBottom) {
+            color = kingColor;
+            kingIndex = index;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ===== Accumulator start. ===== */
+void Accumulator::refresh(const PieceLists& pieceLists)
+{
+    __refresh(pieceLists, false);
+    __refresh(pieceLists, true);
+}
+
+void Accumulator::movTo(const PieceLists& pieceLists, const SPiece& piece, int findex, int tindex,
+    const SPiece& tpiece, const SPiece& eatPiece)
+{
+    const short* weights{ NnueManager::network_.ftWeights.data() };
+    for (bool isBottom : { false, true }) {
+        PieceColor color{};
+        int kingIndex{};
+        // 己方将帅移动（桶改变）或无将帅时重新计算
+        if (!getKing(pieceLists, isBottom, color, kingIndex)
+            || (piece->kind() == PieceKind::KING && piece->color() == color)) {
+            __refresh(pieceLists, isBottom);
+            continue;
+        }
+        auto __getFeature = [&](const SPiece& feaPiece, int index) {
+            return NnueManager::getFeature(isBottom, kingIndex, feaPiece->color() == color, feaPiece->kind(), index);
+        };
+        int adds[2]{ __getFeature(piece, tindex) }, subs[2]{ __getFeature(piece, findex) }, addNum{ 1 }, subNum{ 1 };
+        if (tpiece)
+            subs[subNum++] = __getFeature(tpiece, tindex);
+        if (eatPiece)
+            adds[addNum++] = __getFeature(eatPiece, findex);
+        updateValues(values_[isBottom], weights, adds, addNum, subs, subNum);
+    }
+}
+
+void Accumulator::__refresh(const PieceLists& pieceLists, bool isBottom)
+{
+    auto& network = NnueManager::network_;
+    copy(network.ftBiases.begin(), network.ftBiases.end(), values_[isBottom]);
+    PieceColor color{};
+    int kingIndex{};
+    if (!getKing(pieceLists, isBottom, color, kingIndex))
+        return;
+
+    int adds[32]{}, addNum{ 0 };
+    for (auto pieceColor : { PieceColor::RED, PieceColor::BLACK })
+        for (int k = 0; k < 7; ++k) {
+            PieceKind kind{ static_cast<PieceKind>(k) };
+            const int* indexs{ pieceLists.indexs(pieceColor, kind) };
+            for (int i = pieceLists.count(pieceColor, kind) - 1; i >= 0; --i)
+                adds[addNum++] = NnueManager::getFeature(isBottom, kingIndex, pieceColor == color, kind, indexs[i]);
+        }
+    updateValues(values_[isBottom], network.ftWeights.data(), adds, addNum, nullptr, 0);
+}
+/* ===== Accumulator end. ===== */
+
+/* ===== NnueManager start. ===== */
+// 读入count个T类型的数值
+template <typename T>
+static bool readValues(ifstream& ifs, vector<T>& values, size_t count)
+{
+    values.resize(count);
+    return static_cast<bool>(ifs.read(reinterpret_cast<char*>(values.data()), count * sizeof(T)));
+}
+
+bool NnueManager::load(const string& fileName)
+{
+    ifstream ifs(fileName, ios_base::binary);
+    if (!ifs)
+        return false;
+    char magic[4]{};
+    unsigned header[5]{};
+    if (!ifs.read(magic, sizeof(magic)) || string(magic, sizeof(magic)) != "CCNN"
+        || !ifs.read(reinterpret_cast<char*>(header), sizeof(header)))
+        return false;
+    const unsigned expected[5]{ 1, NnueFeatureNum, NnueHiddenNum, NnueL2Num, NnueL3Num };
+    if (!equal(begin(header), end(header), begin(expected)))
+        return false;
+
+    Network network{};
+    if (!readValues(ifs, network.ftBiases, NnueHiddenNum)
+        || !readValues(ifs, network.ftWeights, static_cast<size_t>(NnueFeatureNum) * NnueHiddenNum)
+        || !readValues(ifs, network.l2Biases, NnueL2Num)
+        || !readValues(ifs, network.l2Weights, NnueL2Num * 2 * NnueHiddenNum)
+        || !readValues(ifs, network.l3Biases, NnueL3Num)
+        || !readValues(ifs, network.l3Weights, NnueL3Num * NnueL2Num)
+        || !ifs.read(reinterpret_cast<char*>(&network.outBias), sizeof(network.outBias))
+        || !readValues(ifs, network.outWeights, NnueL3Num)
+        || ifs.peek() != ifstream::traits_type::eof())
+        return false;
+
+    network_ = move(network);
+    loaded_ = true;
+    return true;
+}
+
+void NnueManager::unload()
+{
+    loaded_ = false;
+    network_ = Network{};
+}
+
+// count个[low, high]之间的随机数值
+template <typename T>
+static void randomValues(mt19937& engine, vector<T>& values, size_t count, int low, int high)
+{
+    uniform_int_distribution<int> distribution{ low, high };
+    values.resize(count);
+    for (auto& value : values)
+        value = static_cast<T>(distribution(engine));
+}
+
+void NnueManager::setRandom(unsigned seed)
+{
+    // 各层权重的范围使输出大多不被截断，输出层权重取全部范围
+    mt19937 engine{ seed };
+    Network network{};
+    randomValues(engine, network.ftBiases, NnueHiddenNum, -32, 96);
+    randomValues(engine, network.ftWeights, static_cast<size_t>(NnueFeatureNum) * NnueHiddenNum, -24, 24);
+    randomValues(engine, network.l2Biases, NnueL2Num, -2048, 2048);
+    randomValues(engine, network.l2Weights, NnueL2Num * 2 * NnueHiddenNum, -16, 16);
+    randomValues(engine, network.l3Biases, NnueL3Num, -2048, 2048);
+    randomValues(engine, network.l3Weights, NnueL3Num * NnueL2Num, -32, 32);
+    network.outBias = uniform_int_distribution<int>{ -1024, 1024 }(engine);
+    randomValues(engine, network.outWeights, NnueL3Num, -128, 127);
+
+    network_ = move(network);
+    loaded_ = true;
+}
+
+int NnueManager::evaluate(const Accumulator& accumulator, bool isBottom)
+{
+    unsigned char input[2 * NnueHiddenNum], hidden2[NnueL2Num], hidden3[NnueL3Num];
+    clipValues(accumulator.values(isBottom), input);
+    clipValues(accumulator.values(!isBottom), input + NnueHiddenNum);
+    denseLayer(input, 2 * NnueHiddenNum, network_.l2Weights.data(), network_.l2Biases.data(), hidden2, NnueL2Num);
+    denseLayer(hidden2, NnueL2Num, network_.l3Weights.data(), network_.l3Biases.data(), hidden3, NnueL3Num);
+    return (network_.outBias + dotProduct(hidden3, network_.outWeights.data(), NnueL3Num)) / 16;
+}
+
+int NnueManager::evaluateScalar(const PieceLists& pieceLists, bool isBottom)
+{
+    int input[2 * NnueHiddenNum]{}, hidden2[NnueL2Num]{}, hidden3[NnueL3Num]{};
+    for (int half = 0; half < 2; ++half) {
+        bool viewBottom{ half == 0 ? isBottom : !isBottom };
+        short values[NnueHiddenNum]{};
+        copy(network_.ftBiases.begin(), network_.ftBiases.end(), values);
+        PieceColor color{};
+        int kingIndex{};
+        if (getKing(pieceLists, viewBottom, color, kingIndex))
+            for (auto pieceColor : { PieceColor::RED, PieceColor::BLACK })
+                for (int k = 0; k < 7; ++k) {
+                    PieceKind kind{ static_cast<PieceKind>(k) };
+                    for (int i = 0; i < pieceLists.count(pieceColor, kind); ++i) {
+                        int feature{ getFeature(viewBottom, kingIndex, pieceColor == color, kind, pieceLists.indexs(pieceColor, kind)[i]) };
+                        for (int h = 0; h < NnueHiddenNum; ++h)
+                            values[h] = static_cast<short>(values[h] + network_.ftWeights[feature * NnueHiddenNum + h]);
+                    }
+                }
+        for (int h = 0; h < NnueHiddenNum; ++h)
+            input[half * NnueHiddenNum + h] = max(0, min(static_cast<int>(values[h]), 127));
+    }
+
+    for (int o = 0; o < NnueL2Num; ++o) {
+        int value{ network_.l2Biases[o] };
+        for (int i = 0; i < 2 * NnueHiddenNum; ++i)
+            value += input[i] * network_.l2Weights[o * 2 * NnueHiddenNum + i];
+        hidden2[o] = value < 0 ? 0 : min(value >> 6, 127);
+    }
+    for (int o = 0; o < NnueL3Num; ++o) {
+        int value{ network_.l3Biases[o] };
+        for (int i = 0; i < NnueL2Num; ++i)
+            value += hidden2[i] * network_.l3Weights[o * NnueL2Num + i];
+        hidden3[o] = value < 0 ? 0 : min(value >> 6, 127);
+    }
+    int output{ network_.outBias };
+    for (int i = 0; i < NnueL3Num; ++i)
+        output += hidden3[i] * network_.outWeights[i];
+    return output / 16;
+}
+
+int NnueManager::getFeature(bool isBottom, int kingIndex, bool isOwn, PieceKind kind, int index)
+{
+    // 顶方视角旋转180度
+    if (!isBottom) {
+        kingIndex = SEATNUM - 1 - kingIndex;
+        index = SEATNUM - 1 - index;
+    }
+    int bucket{ kingIndex / BOARDCOLNUM * 3 + kingIndex % BOARDCOLNUM - 3 };
+    return ((bucket * 2 + !isOwn) * 7 + static_cast<int>(kind)) * SEATNUM + index;
+}
+
+NnueManager::Network NnueManager::network_{};
+bool NnueManager::loaded_{ false };
+/* ===== NnueManager end. ===== */
+}
@@ -0,0 +1,82 @@
+﻿//#pragma once
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "ChessType.h"
+
+#if defined(__AVX2__)
+#define NNUE_USE_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NNUE_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace NnueSpace {
+
+// 可增量更新的神经网络评估(NNUE)：
+// 输入特征为以己方将帅所在九宫位置为桶的(桶, 己方或对方, 种类, 位置)，位置均按己方在底方的视角（顶方旋转180度）
+// 第一层(int16)按底方、顶方两个视角各有一个累加器，随走子增量更新，己方将帅移动时重新计算该视角
+// 走子方、对方视角的累加器截断至[0, 127]拼接后，经两个int8隐藏层（输出右移6位截断至[0, 127]）得到输出，除以16为分数
+// 编译时开启AVX2则使用AVX2指令，否则x86使用SSE2指令，其他平台为标量计算，结果均相同
+constexpr int NnueBucketNum{ 9 }, NnueFeatureNum{ NnueBucketNum * 2 * 7 * SEATNUM },
+              NnueHiddenNum{ 128 }, NnueL2Num{ 32 }, NnueL3Num{ 32 };
+
+// 第一层累加器：[是否底方视角][隐藏单元]
+class Accumulator {
+
+public:
+    const short* values(bool isBottom) const { return values_[isBottom]; }
+
+    // 按棋盘全部棋子重新计算两个视角
+    void refresh(const PieceLists& pieceLists);
+    // 棋子piece由findex移至tindex（原有tpiece）、findex放置eatPiece之后（pieceLists已更新），增量更新
+    void movTo(const PieceLists& pieceLists, const SPiece& piece, int findex, int tindex,
+        const SPiece& tpiece, const SPiece& eatPiece);
+
+private:
+    short values_[2][NnueHiddenNum]{};
+
+    void __refresh(const PieceLists& pieceLists, bool isBottom);
+};
+
+// 网络参数管理类：网络文件于程序启动时载入，未载入时不维护累加器，评估使用子力及位置价值
+// 文件格式（小端）：标识"CCNN"，uint32版本号1，uint32特征数、隐藏单元数、第二层、第三层单元数（须与编译时一致），
+// 其后依次为第一层偏置int16[隐藏]、权重int16[特征][隐藏]，第二层偏置int32[32]、权重int8[32][256]，
+// 第三层偏置int32[32]、权重int8[32][32]，输出偏置int32、权重int8[32]
+// 载入网络后须重新设置棋盘的棋子（累加器据此重新计算），不可在搜索进行中载入
+class NnueManager {
+
+public:
+    static bool isLoaded() { return loaded_; }
+    // 载入成功返回true；文件不能打开或格式有误则返回false，原网络不变
+    static bool load(const string& fileName);
+    // 不使用网络（改用子力及位置价值评估），同样须在搜索之外调用，之后须重新设置棋盘的棋子
+    static void unload();
+    // 设为随机参数的网络（供检验，同样须在搜索之外调用，之后须重新设置棋盘的棋子）
+    static void setRandom(unsigned seed);
+
+    // 走子方（isBottom为其是否底方）视角的评估分数
+    static int evaluate(const Accumulator& accumulator, bool isBottom);
+    // 同evaluate，但按全部棋子从头以标量逐项计算（供检验增量更新及SIMD指令的计算结果）
+    static int evaluateScalar(const PieceLists& pieceLists, bool isBottom);
+
+    // 特征序号：isBottom视角（其将帅位于kingIndex）下，color方（isOwn为是否己方）kind种类棋子位于index
+    static int getFeature(bool isBottom, int kingIndex, bool isOwn, PieceKind kind, int index);
+
+private:
+    struct Network {
+        vector<short> ftBiases, ftWeights;
+        vector<int> l2Biases, l3Biases;
+        vector<signed char> l2Weights, l3Weights, outWeights;
+        int outBias;
+    };
+
+    static Network network_;
+    static bool loaded_;
+
+    friend class Accumulator;
+};
+}
+
+#endif
@@ -78,5 +78,28 @@ const map<PieceColor, wstring> PieceManager::numChars_{
 };
 const wstring PieceManager::ICCSChars_{ L"abcdefghi" };
 const wstring PieceManager::FirstFEN_{ L"rnbakabnr/9/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C5C1/9/RNBAKABNR" };
+
+string PieceManager::getMoveICCS(MoveCode move)
+{
+    string iccs{};
+    for (int index : { MoveList::fromIndex(move), MoveList::toIndex(move) })
+        iccs.append(1, static_cast<char>(getColICCSChar(index % BOARDCOLNUM)))
+            .append(1, static_cast<char>('0' + index / BOARDCOLNUM));
+    return iccs;
+}
+
+MoveCode PieceManager::getICCSMove(const string& iccs)
+{
+    if (iccs.size() != 4)
+        return 0;
+    int indexs[2]{};
+    for (int i = 0; i < 2; ++i) {
+        int col{ getColFromICCSChar(iccs[2 * i]) }, row{ getRowFromICCSChar(iccs[2 * i + 1]) };
+        if (col < 0 || col >= BOARDCOLNUM || row < 0 || row >= BOARDROWNUM)
+            return 0;
+        indexs[i] = row * BOARDCOLNUM + col;
+    }
+    return MoveList::getMove(indexs[0], indexs[1]);
+}
 /* ===== PieceManager end. ===== */
 } 
\ No newline at end of file
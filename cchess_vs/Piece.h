@@ -115,6 +115,23 @@ public:
         return PieceKind::PAWN;
     }
 
+    static PieceKind getKindFromName(wchar_t name)
+    {
+        if (isKing(name))
+            return PieceKind::KING;
+        else if (isAdvisor(name))
+            return PieceKind::ADVISOR;
+        else if (isBishop(name))
+            return PieceKind::BISHOP;
+        else if (isKnight(name))
+            return PieceKind::KNIGHT;
+        else if (isRook(name))
+            return PieceKind::ROOK;
+        else if (isCannon(name))
+            return PieceKind::CANNON;
+        return PieceKind::PAWN;
+    }
+
     static bool isKing(wchar_t name)
     {
         return nameChars_.substr(0, 2).find(name) != wstring::npos;
@@ -171,6 +188,9 @@ public:
     static int getRowFromICCSChar(wchar_t ch) { return ch - '0'; } // 0:48
     static int getColFromICCSChar(wchar_t ch) { return ICCSChars_.find(ch); }
     static wchar_t getColICCSChar(int col) { return ICCSChars_[col]; }
+    // 着法编码与ICCS格式字符串（如h2e2）的转换，字符串格式不符则返回0
+    static string getMoveICCS(MoveCode move);
+    static MoveCode getICCSMove(const string& iccs);
     static wchar_t nullChar() { return nullChar_; };
 
     // 宽字符与数字序号的转换
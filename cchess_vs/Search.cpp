@@ -0,0 +1,704 @@
+﻿#include "Search.h"
+#include "Piece.h"
+#include "Seat.h"
+#include "Tablebase.h"
+
+namespace SearchSpace {
+
+/* ===== TransTable start. ===== */
+TransTable::TransTable(int sizeMB)
+{
+    resize(sizeMB);
+}
+
+void TransTable::resize(int sizeMB)
+{
+    // 桶数取不超过容量的2的幂，以便用掩码取序号
+    unsigned long long bucketNum{ 1 };
+    while (bucketNum * 2 * sizeof(Bucket) <= static_cast<unsigned long long>(max(sizeMB, 1)) << 20)
+        bucketNum *= 2;
+    buckets_ = vector<Bucket>(bucketNum);
+    mask_ = bucketNum - 1;
+}
+
+void TransTable::clear()
+{
+    for (auto& bucket : buckets_)
+        for (auto& entry : bucket.entries) {
+            entry.keyXorData.store(0, memory_order_relaxed);
+            entry.data.store(0, memory_order_relaxed);
+        }
+}
+
+bool TransTable::probe(ZobristKey key, TransData& transData) const
+{
+    for (auto& entry : buckets_[key & mask_].entries) {
+        unsigned long long data{ entry.data.load(memory_order_relaxed) };
+        if (data && (entry.keyXorData.load(memory_order_relaxed) ^ data) == key) {
+            transData = __getTransData(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TransTable::store(ZobristKey key, MoveCode move, int score, int depth, Bound bound)
+{
+    // 替换同一局面的项；否则替换旧的一次搜索的或深度最小的项
+    Entry* replace{ nullptr };
+    int minWorth{ INT_MAX };
+    for (auto& entry : buckets_[key & mask_].entries) {
+        unsigned long long data{ entry.data.load(memory_order_relaxed) };
+        if ((entry.keyXorData.load(memory_order_relaxed) ^ data) == key) {
+            if (!move) // 保留原有的着法
+                move = __getTransData(data).move;
+            replace = &entry;
+            break;
+        }
+        int worth{ __getTransData(data).depth - (__getGeneration(data) == generation_ ? 0 : 256) };
+        if (worth < minWorth) {
+            minWorth = worth;
+            replace = &entry;
+        }
+    }
+    unsigned long long data{ __getData(move, score, depth, bound, generation_) };
+    replace->keyXorData.store(key ^ data, memory_order_relaxed);
+    replace->data.store(data, memory_order_relaxed);
+}
+
+int TransTable::hashfull() const
+{
+    int count{ 0 }, bucketNum{ static_cast<int>(min<size_t>(buckets_.size(), 250)) };
+    for (int i = 0; i < bucketNum; ++i)
+        for (auto& entry : buckets_[i].entries) {
+            unsigned long long data{ entry.data.load(memory_order_relaxed) };
+            if (data && __getGeneration(data) == generation_)
+                ++count;
+        }
+    return count * 1000 / (bucketNum * BucketSize);
+}
+
+unsigned long long TransTable::__getData(MoveCode move, int score, int depth, Bound bound, unsigned generation)
+{
+    return static_cast<unsigned long long>(move)
+        | static_cast<unsigned long long>(static_cast<unsigned short>(score)) << 16
+        | static_cast<unsigned long long>(max(depth, 0) & 0xFF) << 32
+        | static_cast<unsigned long long>(bound) << 40
+        | static_cast<unsigned long long>(generation) << 42;
+}
+
+TransData TransTable::__getTransData(unsigned long long data)
+{
+    return TransData{ static_cast<MoveCode>(data & 0xFFFF),
+        static_cast<short>((data >> 16) & 0xFFFF),
+        static_cast<int>((data >> 32) & 0xFF),
+        static_cast<Bound>((data >> 40) & 0x3) };
+}
+/* ===== TransTable end. ===== */
+
+// 选择性搜索的参数：剃刀、静态裁剪的每层余量，空着裁剪的最小深度
+static constexpr int RazorMargin{ 240 }, FutilityMargin{ 120 }, NullMoveMinDepth{ 2 };
+
+// 后期着法的减少深度：[深度][着法序号]，随二者的对数增长
+struct LmrTable {
+    int reductions[Search::MaxDepth + 1][MoveList::MaxNum];
+};
+
+static LmrTable getLmrTable()
+{
+    LmrTable table{};
+    for (int depth = 1; depth <= Search::MaxDepth; ++depth)
+        for (int count = 1; count < MoveList::MaxNum; ++count)
+            table.reductions[depth][count] = static_cast<int>(0.5 + log(depth) * log(count) / 2.25);
+    return table;
+}
+
+static const LmrTable lmrTable_ = getLmrTable();
+
+/* ===== MovePicker start. ===== */
+MovePicker::MovePicker(const Board& board, PieceColor color, MoveCode transMove, const MoveCode* killers,
+    MoveCode counterMove, const HistoryTable& history)
+    : board_{ board }
+    , checkInfo_{ board.getCheckInfo(color) }
+    , transMove_{ transMove }
+    , killers_{ killers[0], killers[1] }
+    , counterMove_{ counterMove }
+    , history_{ history }
+{
+}
+
+MoveCode MovePicker::next()
+{
+    auto __getValue = [&](int index) { return board_.getKindValue(index); };
+    while (true) {
+        switch (stage_) {
+        case Stage::TRANS:
+            stage_ = Stage::CAPTURE_INIT;
+            if (transMove_ && board_.isCanMove(checkInfo_, transMove_))
+                return transMove_;
+            transMove_ = 0;
+            break;
+        case Stage::CAPTURE_INIT:
+            board_.getCanMoves(moves_, checkInfo_, true);
+            // MVV-LVA：被吃棋子价值高者优先，同等时以价值低的棋子吃
+            for (int i = 0; i < moves_.size(); ++i)
+                scores_[i] = __getValue(MoveList::toIndex(moves_[i])) * 8 - __getValue(MoveList::fromIndex(moves_[i]));
+            current_ = 0;
+            stage_ = Stage::GOOD_CAPTURE;
+            break;
+        case Stage::GOOD_CAPTURE:
+            while (current_ < moves_.size()) {
+                MoveCode move{ __pickBest() };
+                if (move == transMove_)
+                    continue;
+                // 吃价值不低于自身的棋子无须静态交换评估
+                if (__getValue(MoveList::toIndex(move)) < __getValue(MoveList::fromIndex(move)) && board_.see(move) < 0)
+                    badCaptures_[badCount_++] = move;
+                else
+                    return move;
+            }
+            stage_ = Stage::KILLER;
+            break;
+        case Stage::KILLER:
+            while (killerIndex_ < 2) {
+                MoveCode move{ killers_[killerIndex_++] };
+                if (move && move != transMove_ && __isQuietCanMove(move))
+                    return move;
+            }
+            stage_ = Stage::COUNTER;
+            break;
+        case Stage::COUNTER:
+            stage_ = Stage::QUIET_INIT;
+            if (counterMove_ && counterMove_ != transMove_ && counterMove_ != killers_[0]
+                && counterMove_ != killers_[1] && __isQuietCanMove(counterMove_))
+                return counterMove_;
+            counterMove_ = 0;
+            break;
+        case Stage::QUIET_INIT: {
+            int start{ moves_.size() };
+            board_.getCanMoves(moves_, checkInfo_, false);
+            int color{ static_cast<int>(checkInfo_.color) };
+            for (int i = start; i < moves_.size(); ++i)
+                scores_[i] = history_[color][MoveList::fromIndex(moves_[i])][MoveList::toIndex(moves_[i])];
+            current_ = start;
+            stage_ = Stage::QUIET;
+            break;
+        }
+        case Stage::QUIET:
+            while (current_ < moves_.size()) {
+                MoveCode move{ __pickBest() };
+                if (!__isPicked(move))
+                    return move;
+            }
+            stage_ = Stage::BAD_CAPTURE;
+            break;
+        case Stage::BAD_CAPTURE:
+            if (badIndex_ < badCount_)
+                return badCaptures_[badIndex_++];
+            stage_ = Stage::END;
+            break;
+        default:
+            return 0;
+        }
+    }
+}
+
+MoveCode MovePicker::__pickBest()
+{
+    int best{ current_ };
+    for (int i = current_ + 1; i < moves_.size(); ++i)
+        if (scores_[i] > scores_[best])
+            best = i;
+    MoveCode move{ moves_[best] };
+    if (best != current_) {
+        moves_.swap(best, current_);
+        swap(scores_[best], scores_[current_]);
+    }
+    ++current_;
+    return move;
+}
+
+bool MovePicker::__isPicked(MoveCode move) const
+{
+    return move == transMove_ || move == killers_[0] || move == killers_[1] || move == counterMove_;
+}
+
+bool MovePicker::__isQuietCanMove(MoveCode move) const
+{
+    return !board_.isCapture(move) && board_.isCanMove(checkInfo_, move);
+}
+/* ===== MovePicker end. ===== */
+
+/* ===== Search start. ===== */
+Search::Search(const Board& board, PieceColor color, TransTable& transTable, int threadId)
+    : board_{ board.getPieceChars() }
+    , color_{ color }
+    , transTable_{ transTable }
+    , sideKey_{ color == PieceColor::BLACK ? SeatManager::getZobristSide() : 0 }
+    , threadId_{ threadId }
+{
+    board_.setHistory(board);
+}
+
+SearchResult Search::search(const SearchLimits& limits)
+{
+    limits_ = limits;
+    startTime_ = chrono::steady_clock::now();
+    nodes_ = 0;
+    int noLimit{ -1 };
+    timeLimit_.compare_exchange_strong(noLimit, limits.time); // 已由setTimeLimit设定的不予覆盖
+    fill_n(&killers_[0][0], (MaxDepth + 1) * 2, MoveCode{ 0 });
+    fill_n(&history_[0][0][0], 2 * SEATNUM * SEATNUM, 0);
+    fill_n(&counterMoves_[0][0], SEATNUM * SEATNUM, MoveCode{ 0 });
+
+    SearchResult result{ 0, -MateValue, 0, 0, 0, {}, {} };
+    MoveList rootMoves{};
+    board_.getCanMoves(rootMoves, color_, true);
+    board_.getCanMoves(rootMoves, color_, false);
+    if (rootMoves.empty()) // 无着法可走
+        return result;
+    result.move = rootMoves[0];
+
+    int maxDepth{ limits_.depth > 0 ? min(limits_.depth, MaxDepth) : MaxDepth },
+        lineNum{ min(multiPV_, rootMoves.size()) };
+    vector<int> scores(lineNum, 0); // 各变例上一次迭代的分数
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        if (__isSkipDepth(depth))
+            continue;
+        vector<SearchLine> lines{};
+        for (int lineIndex = 0; lineIndex < lineNum; ++lineIndex) {
+            // 渐窄窗口：以上一次迭代的分数为中心，落在窗口外则加宽后重新搜索
+            int score{ scores[lineIndex] }, delta{ AspirationWindow }, alpha{ -InfValue }, beta{ InfValue };
+            if (depth >= 4 && !isMateScore(score)) {
+                alpha = max(score - delta, -InfValue);
+                beta = min(score + delta, InfValue);
+            }
+            int value{};
+            while (true) {
+                value = __searchRoot(depth, alpha, beta, rootMoves, lineIndex);
+                if (stopped_)
+                    break;
+                if (value <= alpha)
+                    alpha = max(value - delta, -InfValue);
+                else if (value >= beta)
+                    beta = min(value + delta, InfValue);
+                else
+                    break;
+                delta *= 2;
+            }
+            if (stopped_)
+                break;
+            lines.push_back(SearchLine{ pv_[0][0], value, vector<MoveCode>(pv_[0], pv_[0] + pvLength_[0]) });
+        }
+        if (stopped_) // 未完成的迭代不予采用
+            break;
+
+        // 之后的变例因搜索不稳定可能分数较高，按分数重新排列，根着法的顺序随之调整
+        stable_sort(lines.begin(), lines.end(),
+            [](const SearchLine& a, const SearchLine& b) { return a.score > b.score; });
+        bool isAllMate{ true };
+        for (int lineIndex = 0; lineIndex < lineNum; ++lineIndex) {
+            scores[lineIndex] = lines[lineIndex].score;
+            isAllMate = isAllMate && isMateScore(scores[lineIndex]);
+            rootMoves.moveToFront(static_cast<int>(find(rootMoves.begin() + lineIndex, rootMoves.end(),
+                                                      lines[lineIndex].move)
+                                      - rootMoves.begin()),
+                lineIndex);
+        }
+        result.move = lines[0].move;
+        result.score = lines[0].score;
+        result.depth = depth;
+        result.pv = lines[0].pv;
+        result.lines = lines;
+        result.nodes = nodes_;
+        result.time = __elapsed();
+        if (infoHandler_)
+            infoHandler_(result);
+        if (isAllMate || (timeLimit_ > 0 && result.time * 2 > timeLimit_))
+            break; // 各变例均已分出胜负，或下一次迭代大致来不及完成
+    }
+    result.nodes = nodes_;
+    result.time = __elapsed();
+    return result;
+}
+
+int Search::__searchRoot(int depth, int alpha, int beta, MoveList& rootMoves, int first)
+{
+    PieceColor othColor{ PieceManager::getOtherColor(color_) };
+    int bestScore{ -InfValue };
+    pvLength_[0] = 0;
+    for (int i = first; i < rootMoves.size(); ++i) {
+        MoveCode move{ rootMoves[i] };
+        auto eatPiece = board_.movTo(move);
+        plyMoves_[0] = move;
+        __addNode();
+        int score{};
+        if (i == first)
+            score = -__alphaBeta(othColor, depth - 1, -beta, -alpha, 1);
+        else { // 以零窗口验证其余着法，超过alpha时再以全窗口重新搜索
+            score = -__alphaBeta(othColor, depth - 1, -alpha - 1, -alpha, 1);
+            if (score > alpha && score < beta)
+                score = -__alphaBeta(othColor, depth - 1, -beta, -alpha, 1);
+        }
+        board_.movBack(move, eatPiece);
+        if (stopped_)
+            break;
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                __updatePV(move, 0);
+                rootMoves.moveToFront(i, first); // 最佳着法在下一次迭代中最先搜索
+            }
+            if (score >= beta)
+                break;
+        }
+    }
+    return bestScore;
+}
+
+int Search::__alphaBeta(PieceColor color, int depth, int alpha, int beta, int ply)
+{
+    pvLength_[ply] = ply;
+    if (__checkStop())
+        return 0;
+    // 局面循环：违例较重的一方判负（不计将死步数），否则为和棋
+    Repetition repetition{ board_.getRepetition() };
+    if (repetition.isRepeated)
+        return repetition.own > repetition.other ? -BanValue : (repetition.own < repetition.other ? BanValue : 0);
+    // 残局库：棋子足够少且找到该组合时，直接取得胜负及步数（只有WDL文件时不知步数，取低于将死分数的胜负分数）
+    if (TablebaseManager::isEnabled() && board_.getPieceCount() <= Tablebase::MaxPieceNum) {
+        int wdl{}, plies{};
+        if (TablebaseManager::probe(board_, color, wdl, plies)) {
+            int value{ plies < 0 ? TablebaseValue - ply : MateValue - ply - plies };
+            return wdl > 0 ? value : (wdl < 0 ? -value : 0);
+        }
+    }
+    if (depth <= 0 || ply >= MaxDepth)
+        return __quiesce(color, alpha, beta, ply);
+
+    // 将死距离裁剪：比已知最快的杀着更慢的变化无须搜索
+    alpha = max(alpha, -MateValue + ply);
+    beta = min(beta, MateValue - ply - 1);
+    if (alpha >= beta)
+        return alpha;
+
+    // 置换表：深度足够且分数类型适用时直接返回（主要变例结点除外），否则其着法最先搜索
+    ZobristKey key{ __getKey() };
+    TransData transData{};
+    MoveCode transMove{ 0 };
+    if (transTable_.probe(key, transData)) {
+        int score{ __scoreFromTrans(transData.score, ply) };
+        if (beta - alpha == 1 && transData.depth >= depth
+            && (transData.bound == Bound::EXACT
+                   || (transData.bound == Bound::LOWER && score >= beta)
+                   || (transData.bound == Bound::UPPER && score <= alpha)))
+            return score;
+        transMove = transData.move;
+    }
+
+    // 分阶段选择着法：剪枝时其后的着法无须生成、排序
+    MoveCode prevMove{ plyMoves_[ply - 1] };
+    MovePicker picker{ board_, color, transMove, killers_[ply],
+        prevMove ? counterMoves_[MoveList::fromIndex(prevMove)][MoveList::toIndex(prevMove)] : MoveCode{ 0 }, history_ };
+    PieceColor othColor{ PieceManager::getOtherColor(color) };
+    bool isPV{ beta - alpha > 1 }, isChecked{ picker.isChecked() };
+    int staticEval{ isChecked ? -InfValue : board_.evaluate(color) };
+    bool canPrune{ !isPV && !isChecked && !isMateScore(alpha) && !isMateScore(beta) };
+
+    // 静态裁剪（反向的无用裁剪）：局面评估减去余量仍不低于beta
+    if (options_.futility && canPrune && depth <= 3 && staticEval - FutilityMargin * depth >= beta)
+        return staticEval;
+    // 剃刀：局面评估加上余量仍不超过alpha，以静态搜索验证
+    if (options_.razoring && canPrune && depth <= 3 && staticEval + RazorMargin * depth <= alpha) {
+        int score{ __quiesce(color, alpha, alpha + 1, ply) };
+        if (stopped_)
+            return 0;
+        if (score <= alpha)
+            return score;
+    }
+    // 空着裁剪：放弃一步仍不低于beta。连续空着、子力少（只剩兵或车马炮不足两个）时不用
+    if (options_.nullMove && canPrune && depth >= NullMoveMinDepth && prevMove && staticEval >= beta
+        && board_.getPieceCount(color, PieceKind::ROOK) + board_.getPieceCount(color, PieceKind::KNIGHT)
+                + board_.getPieceCount(color, PieceKind::CANNON)
+            >= 2) {
+        int reduction{ depth >= 7 ? 3 : 2 };
+        sideKey_ ^= SeatManager::getZobristSide();
+        board_.movNull();
+        plyMoves_[ply] = 0;
+        int score{ -__alphaBeta(othColor, depth - 1 - reduction, -beta, -beta + 1, ply + 1) };
+        board_.movNullBack();
+        sideKey_ ^= SeatManager::getZobristSide();
+        if (stopped_)
+            return 0;
+        if (score >= beta)
+            return isMateScore(score) ? beta : score;
+    }
+
+    // 无用裁剪：局面评估加上余量仍不超过alpha时，不吃子且不将军的着法无须搜索
+    bool isFutile{ options_.futility && canPrune && depth <= 3 && staticEval + FutilityMargin * depth <= alpha };
+    int oldAlpha{ alpha }, bestScore{ -InfValue }, moveCount{ 0 }, quietCount{ 0 };
+    MoveCode bestMove{ 0 }, quiets[64]{};
+    for (MoveCode move{ picker.next() }; move; move = picker.next()) {
+        bool isQuiet{ !board_.isCapture(move) };
+        auto eatPiece = board_.movTo(move);
+        bool isLate{ isQuiet && !isChecked && moveCount > 0 };
+        bool givesCheck{ isLate && (isFutile || options_.lmr) && board_.isKilled(othColor) };
+        if (isLate && isFutile && !givesCheck) {
+            board_.movBack(move, eatPiece);
+            continue;
+        }
+        plyMoves_[ply] = move;
+        __addNode();
+        int score{};
+        if (moveCount++ == 0)
+            score = -__alphaBeta(othColor, depth - 1, -beta, -alpha, ply + 1);
+        else {
+            // 后期着法先以减少的深度、零窗口搜索，超过alpha时再以完整深度验证
+            int reduction{ 0 };
+            if (options_.lmr && isLate && !givesCheck && depth >= 3
+                && move != killers_[ply][0] && move != killers_[ply][1]) {
+                reduction = lmrTable_.reductions[min(depth, MaxDepth)][min(moveCount, MoveList::MaxNum - 1)] - isPV;
+                reduction = max(0, min(reduction, depth - 2));
+            }
+            score = -__alphaBeta(othColor, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1);
+            if (reduction > 0 && score > alpha)
+                score = -__alphaBeta(othColor, depth - 1, -alpha - 1, -alpha, ply + 1);
+            if (score > alpha && score < beta)
+                score = -__alphaBeta(othColor, depth - 1, -beta, -alpha, ply + 1);
+        }
+        board_.movBack(move, eatPiece);
+        if (stopped_)
+            return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            bestMove = move;
+            if (score > alpha) {
+                alpha = score;
+                __updatePV(move, ply);
+                if (score >= beta) {
+                    if (isQuiet)
+                        __updateQuietStats(color, move, quiets, quietCount, depth, ply);
+                    transTable_.store(key, move, __scoreToTrans(score, ply), depth, Bound::LOWER);
+                    return score;
+                }
+            }
+        }
+        if (isQuiet && quietCount < 64)
+            quiets[quietCount++] = move;
+    }
+    // 无着法可走：被将死或困毙，均为负
+    if (moveCount == 0)
+        return -MateValue + ply;
+
+    transTable_.store(key, bestMove, __scoreToTrans(bestScore, ply), depth,
+        bestScore > oldAlpha ? Bound::EXACT : Bound::UPPER);
+    return bestScore;
+}
+
+int Search::__quiesce(PieceColor color, int alpha, int beta, int ply)
+{
+    pvLength_[ply] = ply;
+    if (__checkStop())
+        return 0;
+    if (ply >= MaxDepth)
+        return board_.evaluate(color);
+
+    bool isChecked{ board_.isKilled(color) };
+    int bestScore{ -MateValue + ply };
+    if (!isChecked) {
+        bestScore = board_.evaluate(color);
+        if (bestScore >= beta)
+            return bestScore;
+        alpha = max(alpha, bestScore);
+    }
+
+    // 被将军时为全部应将着法，否则为吃子着法：按静态交换评估由高到低排序，剔除为负的（吃亏的吃子）
+    MoveList moves{};
+    board_.getCanMoves(moves, color, true);
+    if (isChecked)
+        board_.getCanMoves(moves, color, false);
+    MoveCode searchMoves[MoveList::MaxNum]{};
+    int seeValues[MoveList::MaxNum]{}, count{ 0 };
+    for (auto move : moves) {
+        int value{ isChecked ? 0 : board_.see(move) }, j{ count };
+        if (value < 0)
+            continue;
+        for (; j > 0 && seeValues[j - 1] < value; --j) {
+            searchMoves[j] = searchMoves[j - 1];
+            seeValues[j] = seeValues[j - 1];
+        }
+        searchMoves[j] = move;
+        seeValues[j] = value;
+        ++count;
+    }
+
+    PieceColor othColor{ PieceManager::getOtherColor(color) };
+    for (int i = 0; i < count; ++i) {
+        MoveCode move{ searchMoves[i] };
+        auto eatPiece = board_.movTo(move);
+        __addNode();
+        int score{ -__quiesce(othColor, -beta, -alpha, ply + 1) };
+        board_.movBack(move, eatPiece);
+        if (stopped_)
+            return 0;
+
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                __updatePV(move, ply);
+                if (score >= beta)
+                    break;
+            }
+        }
+    }
+    return bestScore;
+}
+
+void Search::__updateQuietStats(PieceColor color, MoveCode move, const MoveCode* quiets, int quietCount, int depth, int ply)
+{
+    if (killers_[ply][0] != move) {
+        killers_[ply][1] = killers_[ply][0];
+        killers_[ply][0] = move;
+    }
+    MoveCode prevMove{ ply > 0 ? plyMoves_[ply - 1] : MoveCode{ 0 } };
+    if (prevMove)
+        counterMoves_[MoveList::fromIndex(prevMove)][MoveList::toIndex(prevMove)] = move;
+
+    auto& history = history_[static_cast<int>(color)];
+    int bonus{ min(depth * depth, 400) };
+    __updateHistory(history[MoveList::fromIndex(move)][MoveList::toIndex(move)], bonus);
+    for (int i = 0; i < quietCount; ++i)
+        __updateHistory(history[MoveList::fromIndex(quiets[i])][MoveList::toIndex(quiets[i])], -bonus);
+}
+
+void Search::__updateHistory(int& value, int bonus)
+{
+    // 越接近上限增加越少，分值保持在[-HistoryMax, HistoryMax]之内，无须定期衰减
+    value += bonus - value * abs(bonus) / HistoryMax;
+}
+
+void Search::__updatePV(MoveCode move, int ply)
+{
+    pv_[ply][ply] = move;
+    for (int i = ply + 1; i < pvLength_[ply + 1]; ++i)
+        pv_[ply][i] = pv_[ply + 1][i];
+    pvLength_[ply] = max(pvLength_[ply + 1], ply + 1);
+}
+
+int Search::__scoreToTrans(int score, int ply)
+{
+    return score >= WinValue ? score + ply : (score <= -WinValue ? score - ply : score);
+}
+
+int Search::__scoreFromTrans(int score, int ply)
+{
+    return score >= WinValue ? score - ply : (score <= -WinValue ? score + ply : score);
+}
+
+int Search::__elapsed() const
+{
+    return static_cast<int>(chrono::duration_cast<chrono::milliseconds>(
+        chrono::steady_clock::now() - startTime_)
+                                .count());
+}
+
+bool Search::__checkStop()
+{
+    // 每1024个结点检查一次结点数、时间限制
+    long long nodes{ nodes_.load(memory_order_relaxed) };
+    int timeLimit{ timeLimit_ };
+    if (!stopped_ && (nodes & 1023) == 0
+        && ((limits_.nodes > 0 && nodes >= limits_.nodes) || (timeLimit > 0 && __elapsed() >= timeLimit)))
+        stopped_ = true;
+    return stopped_;
+}
+bool Search::__isSkipDepth(int depth) const
+{
+    // 辅助线程按序号分组，各组以不同的间隔和相位跳过迭代深度
+    static constexpr int skipSizes[20]{ 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 },
+                         skipPhases[20]{ 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+    if (threadId_ == 0 || depth == 1)
+        return false;
+    int index{ (threadId_ - 1) % 20 };
+    return ((depth + skipPhases[index]) / skipSizes[index]) % 2 == 1;
+}
+/* ===== Search end. ===== */
+
+/* ===== SMPSearch start. ===== */
+SMPSearch::SMPSearch(const Board& board, PieceColor color, TransTable& transTable, int threadNum)
+{
+    for (int id = 0; id < max(threadNum, 1); ++id)
+        searchs_.push_back(unique_ptr<Search>(new Search(board, color, transTable, id)));
+}
+
+SearchResult SMPSearch::search(const SearchLimits& limits)
+{
+    int helperNum{ static_cast<int>(searchs_.size()) - 1 };
+    vector<SearchResult> results(searchs_.size());
+    vector<thread> threads{};
+    for (int id = 1; id <= helperNum; ++id)
+        threads.emplace_back([&, id]() { results[id] = searchs_[id]->search(limits); });
+    results[0] = searchs_[0]->search(limits);
+
+    // 停止状态不会被搜索开始时清除，尚未开始的辅助线程开始后即返回
+    for (int id = 1; id <= helperNum; ++id)
+        searchs_[id]->stop();
+    for (auto& th : threads)
+        th.join();
+
+    SearchResult result{ results[0] };
+    long long nodes{ results[0].nodes };
+    for (int id = 1; id <= helperNum; ++id) {
+        if (results[id].depth > result.depth && results[id].move && results[0].lines.size() <= 1)
+            result = results[id];
+        nodes += results[id].nodes;
+    }
+    result.nodes = nodes;
+    result.time = results[0].time;
+    return result;
+}
+
+void SMPSearch::setOptions(const SearchOptions& options)
+{
+    for (auto& search : searchs_)
+        search->setOptions(options);
+}
+
+void SMPSearch::setMultiPV(int multiPV)
+{
+    searchs_[0]->setMultiPV(multiPV);
+}
+
+void SMPSearch::stop()
+{
+    for (auto& search : searchs_)
+        search->stop();
+}
+
+void SMPSearch::setTimeLimit(int time)
+{
+    searchs_[0]->setTimeLimit(time); // 辅助线程由主线程结束时停止
+}
+
+void SMPSearch::setInfoHandler(const function<void(const SearchResult&)>& infoHandler)
+{
+    searchs_[0]->setInfoHandler([this, infoHandler](const SearchResult& result) {
+        SearchResult totalResult{ result };
+        totalResult.nodes = nodes();
+        infoHandler(totalResult);
+    });
+}
+
+long long SMPSearch::nodes() const
+{
+    long long nodes{ 0 };
+    for (auto& search : searchs_)
+        nodes += search->nodes();
+    return nodes;
+}
+/* ===== SMPSearch end. ===== */
+}
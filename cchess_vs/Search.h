@@ -0,0 +1,246 @@
+﻿//#pragma once
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "Board.h"
+#include "ChessType.h"
+#include "Seat.h"
+
+namespace SearchSpace {
+
+// 搜索限制：深度、结点数、时间（毫秒），结点数、时间为0则不限制
+struct SearchLimits {
+    int depth;
+    long long nodes;
+    int time;
+};
+
+// 多主要变例搜索的一个变例：首着、分数（走子方视角）及主要变例
+struct SearchLine {
+    MoveCode move;
+    int score;
+    vector<MoveCode> pv;
+};
+
+// 搜索结果：最佳着法（0为无着法可走）、分数（走子方视角）、完成的深度及主要变例
+// lines为完成深度的各变例（按分数由高到低，第一变例同move、score、pv），单变例搜索时只有一项
+struct SearchResult {
+    MoveCode move;
+    int score;
+    int depth;
+    long long nodes;
+    int time;
+    vector<MoveCode> pv;
+    vector<SearchLine> lines;
+};
+
+// 选择性搜索的各项裁剪，可在运行时分别开关（供对比测试）
+struct SearchOptions {
+    bool nullMove{ true }; // 空着裁剪：兵类残局及子力少时不用（易出现等着）
+    bool lmr{ true }; // 后期着法减少深度(late move reductions)
+    bool futility{ true }; // 叶结点附近局面评估远低于alpha时跳过不将军的不吃子着法，远高于beta时直接返回
+    bool razoring{ true }; // 叶结点附近局面评估远低于alpha时以静态搜索验证后返回
+};
+
+// 置换表项的分数类型：上界（未超过alpha）、下界（超过beta）、准确值
+enum class Bound : unsigned char {
+    NONE,
+    UPPER,
+    LOWER,
+    EXACT
+};
+
+// 置换表项的内容
+struct TransData {
+    MoveCode move;
+    int score;
+    int depth;
+    Bound bound;
+};
+
+// 置换表类：定长，每桶4项（64字节）；各项存放键值^数据及数据两个64位字，读出时以异或校验，
+// 多个搜索线程可以不加锁同时读写（读到被并发改写的项时校验失败，视为未命中）
+class TransTable {
+
+public:
+    TransTable(int sizeMB = 16);
+
+    void resize(int sizeMB);
+    void clear();
+    // 开始新的一次搜索（由使用者在各线程开始搜索之前调用）：旧的表项优先被替换
+    void newSearch() { generation_ = (generation_ + 1) & 0x3F; }
+
+    bool probe(ZobristKey key, TransData& transData) const;
+    void store(ZobristKey key, MoveCode move, int score, int depth, Bound bound);
+    // 抽样统计本次搜索写入的表项所占千分比
+    int hashfull() const;
+
+private:
+    static constexpr int BucketSize{ 4 };
+
+    struct Entry {
+        atomic<unsigned long long> keyXorData{ 0 }, data{ 0 };
+    };
+    struct Bucket {
+        Entry entries[BucketSize];
+    };
+
+    vector<Bucket> buckets_{};
+    unsigned long long mask_{ 0 };
+    unsigned generation_{ 0 };
+
+    // 数据：着法16位，分数16位，深度8位，分数类型2位，代数6位
+    static unsigned long long __getData(MoveCode move, int score, int depth, Bound bound, unsigned generation);
+    static TransData __getTransData(unsigned long long data);
+    static unsigned __getGeneration(unsigned long long data) { return (data >> 42) & 0x3F; }
+};
+
+// 历史表：[颜色][起点][终点]，不吃子着法引起剪枝时加分，其前已搜索的不吃子着法减分
+typedef int HistoryTable[2][SEATNUM][SEATNUM];
+
+// 分阶段着法选择器：置换表着法、好的吃子（静态交换评估不为负，按MVV-LVA）、两个杀手着法、反驳着法、
+// 其余不吃子着法（按历史表）、坏的吃子；各阶段用到时才生成、排序，剪枝时其后的阶段无须生成
+class MovePicker {
+
+public:
+    MovePicker(const Board& board, PieceColor color, MoveCode transMove, const MoveCode* killers,
+        MoveCode counterMove, const HistoryTable& history);
+
+    // 下一个着法，已无着法则返回0
+    MoveCode next();
+    bool isChecked() const { return checkInfo_.isChecked; }
+
+private:
+    enum class Stage {
+        TRANS,
+        CAPTURE_INIT,
+        GOOD_CAPTURE,
+        KILLER,
+        COUNTER,
+        QUIET_INIT,
+        QUIET,
+        BAD_CAPTURE,
+        END
+    };
+
+    const Board& board_;
+    CheckInfo checkInfo_;
+    MoveCode transMove_, killers_[2], counterMove_;
+    const HistoryTable& history_;
+
+    Stage stage_{ Stage::TRANS };
+    MoveList moves_{};
+    int scores_[MoveList::MaxNum]{}, current_{ 0 }, killerIndex_{ 0 };
+    MoveCode badCaptures_[MoveList::MaxNum]{};
+    int badCount_{ 0 }, badIndex_{ 0 };
+
+    // 取出current_之后分数最高的着法（选择排序，只排已取出的部分）
+    MoveCode __pickBest();
+    // 已在之前阶段取出的着法
+    bool __isPicked(MoveCode move) const;
+    // 杀手、反驳着法须为本局面合法的不吃子着法
+    bool __isQuietCanMove(MoveCode move) const;
+};
+
+// 搜索类：在棋盘副本上以走子、退回进行负极大值alpha-beta搜索
+// 迭代加深，主要变例搜索(PVS)，渐窄窗口(aspiration window)，叶结点之后为静态搜索
+// 多主要变例(multi-PV)：每次迭代依次搜索各变例，后一变例排除之前各变例的首着，共用置换表，之后的变例大多可直接命中
+// 局面循环（含根局面之前的对局历史）：长将、长捉的一方判负，双方同类则为和棋；设定残局库时探查之
+// 着法排序：置换表着法，吃子按MVV-LVA及静态交换评估，不吃子按杀手着法、反驳着法及历史表
+class Search {
+
+public:
+    static constexpr int MaxDepth{ 64 }, MateValue{ 10000 }, InfValue{ 20000 },
+                         WinValue{ MateValue - MaxDepth }, BanValue{ WinValue - 1 },
+                         TablebaseValue{ BanValue - 1 - MaxDepth }, // 残局库只知胜负（无步数）时的分数，不作为将死分数
+                         AspirationWindow{ 50 }, HistoryMax{ 16384 };
+
+    // 棋盘、棋子对象不能共享，据棋子字符串新建棋盘副本（接续其局面历史）；置换表可由多个搜索共享
+    // threadId大于0时为多线程搜索的辅助线程，按序号跳过部分迭代深度，与其他线程错开
+    Search(const Board& board, PieceColor color, TransTable& transTable, int threadId = 0);
+
+    SearchResult search(const SearchLimits& limits);
+    void setOptions(const SearchOptions& options) { options_ = options; }
+    // 搜索的变例数（不超过根局面的着法数）
+    void setMultiPV(int multiPV) { multiPV_ = max(multiPV, 1); }
+    // 以下可由其他线程调用，在搜索开始之前调用的同样有效（每个搜索对象只搜索一次）：
+    // 使搜索尽快返回；设定时间限制（自搜索开始计，用于后台思考命中），优先于search的limits.time
+    void stop() { stopped_ = true; }
+    void setTimeLimit(int time) { timeLimit_ = time; }
+    // 每完成一次迭代时调用（输出搜索信息）
+    void setInfoHandler(const function<void(const SearchResult&)>& infoHandler) { infoHandler_ = infoHandler; }
+    long long nodes() const { return nodes_.load(memory_order_relaxed); }
+
+    // 分数是否为将死分数
+    static bool isMateScore(int score) { return abs(score) >= WinValue; }
+
+private:
+    Board board_;
+    PieceColor color_;
+    TransTable& transTable_;
+    ZobristKey sideKey_;
+    int threadId_;
+
+    SearchLimits limits_{};
+    SearchOptions options_{};
+    int multiPV_{ 1 };
+    chrono::steady_clock::time_point startTime_{};
+    atomic<long long> nodes_{ 0 }; // 仅本线程写入，其他线程可读取
+    atomic<int> timeLimit_{ -1 }; // -1为未设定，搜索开始时取limits.time
+    atomic<bool> stopped_{ false };
+    function<void(const SearchResult&)> infoHandler_{};
+
+    MoveCode pv_[MaxDepth + 1][MaxDepth + 1]{}; // 三角形主要变例表
+    int pvLength_[MaxDepth + 1]{};
+
+    // 着法排序的历史信息，各线程各有一份：杀手着法[层][2]，历史表，反驳着法[对方上一着起点][终点]，各层所走着法
+    MoveCode killers_[MaxDepth + 1][2]{};
+    HistoryTable history_{};
+    MoveCode counterMoves_[SEATNUM][SEATNUM]{};
+    MoveCode plyMoves_[MaxDepth + 1]{};
+
+    // 搜索根局面第first个及之后的着法（之前的为已搜索变例的首着）
+    int __searchRoot(int depth, int alpha, int beta, MoveList& rootMoves, int first);
+    int __alphaBeta(PieceColor color, int depth, int alpha, int beta, int ply);
+    // 静态搜索：未被将军时只搜索静态交换评估不为负的吃子着法（可选择不吃子而取局面评估），被将军时搜索全部应将着法
+    int __quiesce(PieceColor color, int alpha, int beta, int ply);
+    void __updatePV(MoveCode move, int ply);
+    // 不吃子着法引起剪枝：更新杀手着法、反驳着法，历史表加分（之前搜索过的不吃子着法减分）
+    void __updateQuietStats(PieceColor color, MoveCode move, const MoveCode* quiets, int quietCount, int depth, int ply);
+    static void __updateHistory(int& value, int bonus);
+    // 置换表的键值：黑方走时含走子方键值（棋盘副本建立时不含走子方，之后每走一步切换一次，空着时另行切换）
+    ZobristKey __getKey() const { return board_.key() ^ sideKey_; }
+    // 将死分数在置换表中按距当前结点的步数存放
+    static int __scoreToTrans(int score, int ply);
+    static int __scoreFromTrans(int score, int ply);
+
+    void __addNode() { nodes_.store(nodes_.load(memory_order_relaxed) + 1, memory_order_relaxed); }
+    int __elapsed() const;
+    bool __checkStop();
+    bool __isSkipDepth(int depth) const;
+};
+
+// 多线程搜索类(Lazy SMP)：各线程的Search各有棋盘副本，共享置换表，同时搜索同一根局面，
+// 辅助线程的迭代深度与主线程错开；主线程完成时停止全部辅助线程，取完成深度最大的结果
+// 多主要变例只由主线程搜索（辅助线程为单变例，只填充置换表），取主线程的结果
+class SMPSearch {
+
+public:
+    SMPSearch(const Board& board, PieceColor color, TransTable& transTable,
+        int threadNum = thread::hardware_concurrency());
+
+    SearchResult search(const SearchLimits& limits);
+    void setOptions(const SearchOptions& options);
+    void setMultiPV(int multiPV);
+    void stop();
+    void setTimeLimit(int time);
+    // 主线程每完成一次迭代时调用，结点数为全部线程之和
+    void setInfoHandler(const function<void(const SearchResult&)>& infoHandler);
+    long long nodes() const;
+
+private:
+    vector<unique_ptr<Search>> searchs_{};
+};
+}
+
+#endif
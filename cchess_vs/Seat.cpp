@@ -3,10 +3,35 @@
 
 namespace SeatSpace {
 
+/* ===== PieceLists start. ===== */
+void PieceLists::put(PieceColor color, PieceKind kind, int index)
+{
+    int c{ static_cast<int>(color) }, k{ static_cast<int>(kind) };
+    assert(counts_[c][k] < KindMaxNum_);
+    listIndexs_[index] = counts_[c][k];
+    indexs_[c][k][counts_[c][k]++] = index;
+}
+
+void PieceLists::remove(PieceColor color, PieceKind kind, int index)
+{
+    int c{ static_cast<int>(color) }, k{ static_cast<int>(kind) },
+        lastIndex{ indexs_[c][k][--counts_[c][k]] };
+    // 以表中最后一个位置填补被删除的位置
+    indexs_[c][k][listIndexs_[index]] = lastIndex;
+    listIndexs_[lastIndex] = listIndexs_[index];
+}
+
+void PieceLists::clear()
+{
+    *this = PieceLists{};
+}
+/* ===== PieceLists end. ===== */
+
 /* ===== Seat start. ===== */
-Seat::Seat(int row, int col)
+Seat::Seat(int row, int col, Seats* seats)
     : row_{ row }
     , col_{ col }
+    , seats_{ seats }
 {
 }
 
@@ -19,6 +44,8 @@ bool Seat::isSameColor(const SSeat& seat) const
 const SPiece Seat::movTo(SSeat& tseat, const SPiece& eatPiece)
 {
     auto tpiece = tseat->piece();
+    if (seats_)
+        seats_->__movTo(*this, *tseat, tpiece, eatPiece);
     tseat->setPiece(this->piece());
     setPiece(eatPiece);
     return tpiece;
@@ -32,11 +59,14 @@ const wstring Seat::toString() const
 }
 /* ===== Seat end. ===== */
 
+// 静态交换评估中将帅的价值：大于其余棋子之和
+static constexpr int SeeKingValue{ 10000 };
+
 /* ===== Seats start. ===== */
 Seats::Seats()
 {
     for (auto& rowcol_pair : SeatManager::getAllRowcols())
-        allSeats_.push_back(make_shared<Seat>(rowcol_pair.first, rowcol_pair.second));
+        allSeats_.push_back(make_shared<Seat>(rowcol_pair.first, rowcol_pair.second, this));
 }
 
 inline const SSeat& Seats::getSeat(int row, int col) const
@@ -56,11 +86,15 @@ inline const SSeat& Seats::getSeat(RowCol_pair rowcol_pair) const
 
 const SSeat& Seats::getKingSeat(bool isBottom) const
 {
-    for (auto& rowcol : SeatManager::getKingRowcols(isBottom)) {
-        auto& seat = getSeat(rowcol);
-        auto& piece = seat->piece();
-        if (piece && PieceManager::isKing(piece->name()))
-            return seat;
+    return allSeats_[getKingIndex(isBottom)];
+}
+
+int Seats::getKingIndex(bool isBottom) const
+{
+    for (auto color : { PieceColor::RED, PieceColor::BLACK }) {
+        int index{ pieceLists_.kingIndex(color) };
+        if (index >= 0 && SeatManager::isBottom(index / BOARDCOLNUM) == isBottom)
+            return index;
     }
     throw runtime_error("将（帅）不在棋盘上面!");
 }
@@ -85,39 +119,322 @@ SSeat_vector Seats::getPutSeats(bool isBottom, const SPiece& piece) const
 SSeat_vector Seats::getMoveSeats(bool isBottom, const SSeat& fseat) const
 {
     //assert(fseat->piece()); // 该位置需有棋子，由调用者board来保证？
-    switch (fseat->piece()->kind()) {
+    auto& piece = fseat->piece();
+    return __getSeats(getMoveBoard(isBottom, piece->kind(), fseat->index())
+        & ~bitBoards_.pieces(piece->color())); // 排除同颜色棋子
+}
+
+BitBoard Seats::getMoveBoard(bool isBottom, PieceKind kind, int index) const
+{
+    return isBottom ? getMoveBoard<true>(kind, index) : getMoveBoard<false>(kind, index);
+}
+
+template <bool IsBottom>
+BitBoard Seats::getMoveBoard(PieceKind kind, int index) const
+{
+    switch (kind) {
     case PieceKind::ROOK:
-        return getRookMoveSeats(fseat);
+        return __getRook_MoveBoard(index);
     case PieceKind::KNIGHT:
-        return getKnightMoveSeats(isBottom, fseat);
+        return __getNonObs_MoveBoard(SeatManager::getKnightObs_Moves(index));
     case PieceKind::CANNON:
-        return getCannonMoveSeats(fseat);
+        return __getCannon_MoveBoard(index);
     case PieceKind::BISHOP:
-        return getBishopMoveSeats(isBottom, fseat);
+        return __getNonObs_MoveBoard(SeatManager::getBishopObs_Moves(IsBottom, index));
     case PieceKind::ADVISOR:
-        return getAdvisorMoveSeats(isBottom, fseat);
+        return SeatManager::getAdvisorMoveBoard(IsBottom, index);
     case PieceKind::PAWN:
-        return getPawnMoveSeats(isBottom, fseat);
+        return SeatManager::getPawnMoveBoard(IsBottom, index);
     case PieceKind::KING:
-        return getKingMoveSeats(isBottom, fseat);
+        return SeatManager::getKingMoveBoard(IsBottom, index);
     default:
         break;
     };
-    return SSeat_vector{};
+    return BitBoard{};
+}
+
+template <bool IsBottom>
+void Seats::getMoves(MoveList& moves, PieceColor color, bool isCapture) const
+{
+    for (auto kind : { PieceKind::KING, PieceKind::ADVISOR, PieceKind::BISHOP, PieceKind::KNIGHT,
+             PieceKind::ROOK, PieceKind::CANNON, PieceKind::PAWN }) {
+        const int* indexs{ pieceLists_.indexs(color, kind) };
+        for (int i = pieceLists_.count(color, kind) - 1; i >= 0; --i)
+            __addMoves<IsBottom>(moves, color, kind, indexs[i], isCapture);
+    }
+}
+template void Seats::getMoves<true>(MoveList& moves, PieceColor color, bool isCapture) const;
+template void Seats::getMoves<false>(MoveList& moves, PieceColor color, bool isCapture) const;
+
+template <bool IsBottom>
+void Seats::getMoves(MoveList& moves, int index, bool isCapture) const
+{
+    auto& piece = allSeats_[index]->piece();
+    assert(piece);
+    __addMoves<IsBottom>(moves, piece->color(), piece->kind(), index, isCapture);
+}
+template void Seats::getMoves<true>(MoveList& moves, int index, bool isCapture) const;
+template void Seats::getMoves<false>(MoveList& moves, int index, bool isCapture) const;
+
+bool Seats::isAttacked(PieceColor color, bool isBottom, int index) const
+{
+    return isBottom ? isAttacked<true>(color, index) : isAttacked<false>(color, index);
+}
+
+template <bool IsBottom>
+bool Seats::isAttacked(PieceColor color, int index) const
+{
+    auto& occupied = bitBoards_.occupied();
+    auto &rooks = bitBoards_.pieces(color, PieceKind::ROOK),
+         &cannons = bitBoards_.pieces(color, PieceKind::CANNON),
+         &knights = bitBoards_.pieces(color, PieceKind::KNIGHT),
+         &king = bitBoards_.pieces(color, PieceKind::KING);
+    // 车（纵线上还有将帅对面）：每个方向第一个棋子；炮：每个方向隔一个棋子之后的第一个棋子
+    auto& lines = SeatManager::getRookCannonMove_Lines(index);
+    for (int line = 0; line < 4; ++line) {
+        int i{ 0 }, count{ lines.count[line] };
+        while (i < count && !occupied.test(lines.tos[line][i]))
+            ++i;
+        if (i == count)
+            continue;
+        int tindex{ lines.tos[line][i] };
+        if (rooks.test(tindex) || (line >= 2 && king.test(tindex)))
+            return true;
+        while (++i < count)
+            if (occupied.test(tindex = lines.tos[line][i])) {
+                if (cannons.test(tindex))
+                    return true;
+                break;
+            }
+    }
+    // 马：马腿位于被攻击位置的斜角
+    auto& obs_Attacks = SeatManager::getKnightObs_Attacks(index);
+    for (int i = 0; i < obs_Attacks.count; ++i)
+        if (knights.test(obs_Attacks.tos[i]) && !occupied.test(obs_Attacks.obs[i]))
+            return true;
+    // 兵：前方或过河后的左右
+    return (SeatManager::getPawnAttackBoard(IsBottom, index) & bitBoards_.pieces(color, PieceKind::PAWN)).any();
+}
+template bool Seats::isAttacked<true>(PieceColor color, int index) const;
+template bool Seats::isAttacked<false>(PieceColor color, int index) const;
+
+CheckInfo Seats::getCheckInfo(PieceColor color, bool isBottom) const
+{
+    return isBottom ? getCheckInfo<true>(color) : getCheckInfo<false>(color);
+}
+
+template <bool IsBottom>
+CheckInfo Seats::getCheckInfo(PieceColor color) const
+{
+    CheckInfo checkInfo{ color, pieceLists_.kingIndex(color) };
+    int kingIndex{ checkInfo.kingIndex };
+    PieceColor othColor{ PieceManager::getOtherColor(color) };
+    checkInfo.isChecked = isAttacked<!IsBottom>(othColor, kingIndex);
+
+    auto& occupied = bitBoards_.occupied();
+    auto &rooks = bitBoards_.pieces(othColor, PieceKind::ROOK),
+         &cannons = bitBoards_.pieces(othColor, PieceKind::CANNON),
+         &king = bitBoards_.pieces(othColor, PieceKind::KING);
+    auto& lines = SeatManager::getRookCannonMove_Lines(kingIndex);
+    for (int line = 0; line < 4; ++line) {
+        BitBoard pinBoard{};
+        bool isPinLine{ false };
+        for (int i = 0, num = 0; i < lines.count[line] && num < 3; ++i) {
+            int index{ lines.tos[line][i] };
+            if (num < 2)
+                pinBoard.set(index);
+            if (!occupied.test(index))
+                continue;
+            if (cannons.test(index) || (num < 2 && (rooks.test(index) || (line >= 2 && king.test(index)))))
+                isPinLine = true;
+            ++num;
+        }
+        if (isPinLine)
+            checkInfo.pinBoards[line] = pinBoard;
+    }
+
+    auto& knights = bitBoards_.pieces(othColor, PieceKind::KNIGHT);
+    auto& obs_Attacks = SeatManager::getKnightObs_Attacks(kingIndex);
+    for (int i = 0; i < obs_Attacks.count; ++i)
+        if (knights.test(obs_Attacks.tos[i]))
+            checkInfo.legBoard.set(obs_Attacks.obs[i]);
+    return checkInfo;
+}
+template CheckInfo Seats::getCheckInfo<true>(PieceColor color) const;
+template CheckInfo Seats::getCheckInfo<false>(PieceColor color) const;
+
+bool Seats::isLegalMove(const CheckInfo& checkInfo, int findex, int tindex) const
+{
+    PieceColor othColor{ PieceManager::getOtherColor(checkInfo.color) };
+    // 马腿上的棋子移开，除非吃掉该马
+    if (checkInfo.legBoard.test(findex)) {
+        auto& knights = bitBoards_.pieces(othColor, PieceKind::KNIGHT);
+        auto& obs_Attacks = SeatManager::getKnightObs_Attacks(checkInfo.kingIndex);
+        for (int i = 0; i < obs_Attacks.count; ++i)
+            if (obs_Attacks.obs[i] == findex && obs_Attacks.tos[i] != tindex && knights.test(obs_Attacks.tos[i]))
+                return false;
+    }
+
+    // 牵制线上：走子后该方向第一个棋子不能是对方车（将帅），第二个棋子不能是对方炮
+    auto& occupied = bitBoards_.occupied();
+    auto &rooks = bitBoards_.pieces(othColor, PieceKind::ROOK),
+         &cannons = bitBoards_.pieces(othColor, PieceKind::CANNON),
+         &king = bitBoards_.pieces(othColor, PieceKind::KING);
+    auto& lines = SeatManager::getRookCannonMove_Lines(checkInfo.kingIndex);
+    for (int line = 0; line < 4; ++line) {
+        auto& pinBoard = checkInfo.pinBoards[line];
+        if (!pinBoard.test(findex) && !pinBoard.test(tindex))
+            continue;
+        for (int i = 0, num = 0; i < lines.count[line] && num < 2; ++i) {
+            int index{ lines.tos[line][i] };
+            if (index == tindex) { // 走至的位置为本方棋子
+                ++num;
+                continue;
+            }
+            if (index == findex || !occupied.test(index))
+                continue;
+            if ((num == 0 && (rooks.test(index) || (line >= 2 && king.test(index))))
+                || (num == 1 && cannons.test(index)))
+                return false;
+            ++num;
+        }
+    }
+    return true;
+}
+
+int Seats::see(PieceColor color, bool isBottom, int findex, int tindex) const
+{
+    auto& kindValues = EvalManager::params().kindValues;
+    auto __getValue = [&](PieceKind kind) {
+        return kind == PieceKind::KING ? SeeKingValue : kindValues[static_cast<int>(kind)];
+    };
+
+    // gains[d]：第d次吃子后，该次吃子一方的净得分（假定对方随后可以不再吃回）
+    int gains[32]{}, depth{ 0 };
+    PieceColor sideColor{ PieceManager::getOtherColor(color) }; // 将要吃回的一方
+    bool sideIsBottom{ !isBottom };
+    unsigned char eatCode{ mailbox_.code(Mailbox::getSquare(tindex)) };
+    gains[0] = eatCode == Mailbox::EMPTY ? 0 : __getValue(Mailbox::getKind(eatCode));
+    int attackerValue{ __getValue(Mailbox::getKind(mailbox_.code(Mailbox::getSquare(findex)))) };
+    BitBoard occupied{ bitBoards_.occupied() };
+    occupied.reset(findex);
+    while (true) {
+        PieceKind kind{};
+        int index{ __getLeastAttacker(sideColor, sideIsBottom, tindex, occupied, kind) };
+        if (index < 0)
+            break;
+        ++depth;
+        gains[depth] = attackerValue - gains[depth - 1];
+        if (max(-gains[depth - 1], gains[depth]) < 0) // 无论之后如何，均不能改变结果
+            break;
+        attackerValue = __getValue(kind);
+        occupied.reset(index);
+        sideColor = PieceManager::getOtherColor(sideColor);
+        sideIsBottom = !sideIsBottom;
+    }
+    while (depth > 0) {
+        gains[depth - 1] = -max(-gains[depth - 1], gains[depth]);
+        --depth;
+    }
+    return gains[0];
+}
+
+int Seats::__getLeastAttacker(PieceColor color, bool isBottom, int index, const BitBoard& occupied, PieceKind& kind) const
+{
+    auto __pieces = [&](PieceKind pieceKind) { return bitBoards_.pieces(color, pieceKind) & occupied; };
+    // 兵：前方或过河后的左右
+    BitBoard pawns{ SeatManager::getPawnAttackBoard(isBottom, index) & __pieces(PieceKind::PAWN) };
+    if (pawns.any()) {
+        kind = PieceKind::PAWN;
+        return pawns.first();
+    }
+    // 士、象：由其所在位置查走子表
+    for (BitBoard advisors{ __pieces(PieceKind::ADVISOR) }; advisors.any();) {
+        int findex{ advisors.popFirst() };
+        if (SeatManager::getAdvisorMoveBoard(isBottom, findex).test(index)) {
+            kind = PieceKind::ADVISOR;
+            return findex;
+        }
+    }
+    for (BitBoard bishops{ __pieces(PieceKind::BISHOP) }; bishops.any();) {
+        int findex{ bishops.popFirst() };
+        auto& obs_Moves = SeatManager::getBishopObs_Moves(isBottom, findex);
+        for (int i = 0; i < obs_Moves.count; ++i)
+            if (obs_Moves.tos[i] == index && !occupied.test(obs_Moves.obs[i])) {
+                kind = PieceKind::BISHOP;
+                return findex;
+            }
+    }
+    // 马：马腿位于被攻击位置的斜角
+    BitBoard knights{ __pieces(PieceKind::KNIGHT) };
+    auto& obs_Attacks = SeatManager::getKnightObs_Attacks(index);
+    for (int i = 0; i < obs_Attacks.count; ++i)
+        if (knights.test(obs_Attacks.tos[i]) && !occupied.test(obs_Attacks.obs[i])) {
+            kind = PieceKind::KNIGHT;
+            return obs_Attacks.tos[i];
+        }
+    // 炮、车：每个方向第一个棋子为车，隔一个棋子（炮架）之后的第一个棋子为炮
+    BitBoard cannons{ __pieces(PieceKind::CANNON) }, rooks{ __pieces(PieceKind::ROOK) };
+    int rookIndex{ -1 };
+    auto& lines = SeatManager::getRookCannonMove_Lines(index);
+    for (int line = 0; line < 4; ++line) {
+        int i{ 0 }, count{ lines.count[line] };
+        while (i < count && !occupied.test(lines.tos[line][i]))
+            ++i;
+        if (i == count)
+            continue;
+        if (rooks.test(lines.tos[line][i]))
+            rookIndex = lines.tos[line][i];
+        while (++i < count)
+            if (occupied.test(lines.tos[line][i])) {
+                if (cannons.test(lines.tos[line][i])) {
+                    kind = PieceKind::CANNON;
+                    return lines.tos[line][i];
+                }
+                break;
+            }
+    }
+    if (rookIndex >= 0) {
+        kind = PieceKind::ROOK;
+        return rookIndex;
+    }
+    // 将帅：吃子后不能处于对方攻击之下
+    BitBoard king{ __pieces(PieceKind::KING) };
+    if (king.any() && SeatManager::getKingMoveBoard(isBottom, king.first()).test(index)) {
+        BitBoard kingOccupied{ occupied };
+        kingOccupied.reset(king.first());
+        PieceKind othKind{};
+        if (__getLeastAttacker(PieceManager::getOtherColor(color), !isBottom, index, kingOccupied, othKind) < 0) {
+            kind = PieceKind::KING;
+            return king.first();
+        }
+    }
+    return -1;
 }
 
 SSeat_vector Seats::getLiveSeats(PieceColor color, wchar_t name, int col, bool getStronge) const
 {
+    int indexs[PIECENUM / 2]{}, count{ 0 };
+    auto __addKind = [&](PieceKind kind) {
+        const int* kindIndexs{ pieceLists_.indexs(color, kind) };
+        for (int i = pieceLists_.count(color, kind) - 1; i >= 0; --i)
+            if (col == BLANKCOL || col == kindIndexs[i] % BOARDCOLNUM)
+                indexs[count++] = kindIndexs[i];
+    };
+    if (name != BLANKNAME)
+        __addKind(PieceManager::getKindFromName(name));
+    else if (getStronge)
+        for (auto kind : { PieceKind::KNIGHT, PieceKind::ROOK, PieceKind::CANNON, PieceKind::PAWN })
+            __addKind(kind);
+    else
+        for (auto kind : { PieceKind::KING, PieceKind::ADVISOR, PieceKind::BISHOP, PieceKind::KNIGHT,
+                 PieceKind::ROOK, PieceKind::CANNON, PieceKind::PAWN })
+            __addKind(kind);
+    sort(indexs, indexs + count); // 按位置序号由小到大
+
     SSeat_vector seats{};
-    for (auto& seat : allSeats_) {
-        auto& piece = seat->piece();
-        if (piece
-            && color == piece->color()
-            && (name == BLANKNAME || name == piece->name())
-            && (col == BLANKCOL || col == seat->col())
-            && (!getStronge || PieceManager::isStronge(piece->name())))
-            seats.push_back(seat);
-    }
+    for (int i = 0; i < count; ++i)
+        seats.push_back(allSeats_[indexs[i]]);
     return seats;
 }
 
@@ -147,6 +464,22 @@ void Seats::setBoardPieces(const vector<SPiece>& boardPieces)
     int index{ 0 };
     for_each(allSeats_.begin(), allSeats_.end(),
         [&](const SSeat& seat) { seat->setPiece(boardPieces[index++]); });
+    bitBoards_.clear();
+    pieceLists_.clear();
+    mailbox_.clear();
+    evaluation_.clear();
+    for (auto& seat : allSeats_) {
+        auto& piece = seat->piece();
+        if (piece) {
+            bitBoards_.put(piece->color(), piece->kind(), seat->index());
+            pieceLists_.put(piece->color(), piece->kind(), seat->index());
+            mailbox_.put(piece->color(), piece->kind(), seat->index());
+            evaluation_.put(piece->color(), piece->kind(), seat->index());
+        }
+    }
+    if (NnueManager::isLoaded())
+        accumulator_.refresh(pieceLists_);
+    key_ = __getKey();
 }
 
 void Seats::changeSide(const ChangeType ct, const shared_ptr<Pieces>& pieces)
@@ -182,6 +515,44 @@ const wstring Seats::toString() const
     return wos.str();
 }
 
+void Seats::__movTo(const Seat& fseat, const Seat& tseat, const SPiece& tpiece, const SPiece& eatPiece)
+{
+    int findex{ fseat.index() }, tindex{ tseat.index() };
+    auto __remove = [&](const SPiece& piece, int index) {
+        if (piece) {
+            bitBoards_.remove(piece->color(), piece->kind(), index);
+            pieceLists_.remove(piece->color(), piece->kind(), index);
+            mailbox_.remove(index);
+            evaluation_.remove(piece->color(), piece->kind(), index);
+        }
+    };
+    auto __put = [&](const SPiece& piece, int index) {
+        if (piece) {
+            bitBoards_.put(piece->color(), piece->kind(), index);
+            pieceLists_.put(piece->color(), piece->kind(), index);
+            mailbox_.put(piece->color(), piece->kind(), index);
+            evaluation_.put(piece->color(), piece->kind(), index);
+        }
+    };
+    __remove(fseat.piece(), findex);
+    __remove(tpiece, tindex);
+    __put(fseat.piece(), tindex);
+    __put(eatPiece, findex);
+    if (NnueManager::isLoaded())
+        accumulator_.movTo(pieceLists_, fseat.piece(), findex, tindex, tpiece, eatPiece);
+    key_ ^= (SeatManager::getZobrist(fseat.piece(), findex) ^ SeatManager::getZobrist(fseat.piece(), tindex)
+        ^ SeatManager::getZobrist(tpiece, tindex) ^ SeatManager::getZobrist(eatPiece, findex)
+        ^ SeatManager::getZobristSide());
+}
+
+ZobristKey Seats::__getKey() const
+{
+    ZobristKey key{ 0 };
+    for (int index = 0; index < SEATNUM; ++index)
+        key ^= SeatManager::getZobrist(allSeats_[index]->piece(), index);
+    return key;
+}
+
 vector<SSeat> Seats::getAllSeats() const
 {
     return allSeats_;
@@ -189,120 +560,127 @@ vector<SSeat> Seats::getAllSeats() const
 
 SSeat_vector Seats::getKingSeats(bool isBottom) const
 {
-    return __getMoveSeats(SeatManager::getKingRowcols(isBottom));
+    return __getSeats(SeatManager::getKingRowcols(isBottom));
 }
 
 SSeat_vector Seats::getAdvisorSeats(bool isBottom) const
 {
-    return __getMoveSeats(SeatManager::getAdvisorRowcols(isBottom));
+    return __getSeats(SeatManager::getAdvisorRowcols(isBottom));
 }
 
 SSeat_vector Seats::getBishopSeats(bool isBottom) const
 {
-    return __getMoveSeats(SeatManager::getBishopRowcols(isBottom));
+    return __getSeats(SeatManager::getBishopRowcols(isBottom));
 }
 
 SSeat_vector Seats::getPawnSeats(bool isBottom) const
 {
-    return __getMoveSeats(SeatManager::getPawnRowcols(isBottom));
+    return __getSeats(SeatManager::getPawnRowcols(isBottom));
 }
 
-vector<SSeat> Seats::getKingMoveSeats(bool isBottom, const SSeat& fseat) const
+SSeat_vector Seats::__getSeats(const RowCol_pair_vector& rowcol_pairs) const
 {
-    return __getMoveSeats(SeatManager::getKingMoveRowcols(isBottom, fseat->row(), fseat->col()), fseat);
-}
-
-vector<SSeat> Seats::getAdvisorMoveSeats(bool isBottom, const SSeat& fseat) const
-{
-    return __getMoveSeats(SeatManager::getAdvisorMoveRowcols(isBottom, fseat->row(), fseat->col()), fseat);
+    SSeat_vector seats{};
+    for (auto& rowcol_pair : rowcol_pairs)
+        seats.push_back(getSeat(rowcol_pair));
+    return seats;
 }
 
-vector<SSeat> Seats::getBishopMoveSeats(bool isBottom, const SSeat& fseat) const
+SSeat_vector Seats::__getSeats(BitBoard board) const
 {
-    return __getMoveSeats(__getNonObs_MoveRowcols(isBottom, fseat, *SeatManager::getBishopObs_MoveRowcols), fseat);
+    SSeat_vector seats{};
+    while (board.any())
+        seats.push_back(allSeats_[board.popFirst()]);
+    return seats;
 }
 
-vector<SSeat> Seats::getKnightMoveSeats(bool isBottom, const SSeat& fseat) const
+template <bool IsBottom>
+void Seats::__addMoves(MoveList& moves, PieceColor color, PieceKind kind, int index, bool isCapture) const
 {
-    return __getMoveSeats(__getNonObs_MoveRowcols(isBottom, fseat, *SeatManager::getKnightObs_MoveRowcols), fseat);
+    BitBoard moveBoard{ getMoveBoard<IsBottom>(kind, index)
+        & (isCapture ? bitBoards_.pieces(PieceManager::getOtherColor(color)) : ~bitBoards_.occupied()) };
+    while (moveBoard.any())
+        moves.add(index, moveBoard.popFirst());
 }
 
-vector<SSeat> Seats::getRookMoveSeats(const SSeat& fseat) const
+BitBoard Seats::__getNonObs_MoveBoard(const ObsMoves& obs_Moves) const
 {
-    return __getMoveSeats(__getRook_MoveRowcols(fseat), fseat);
+    BitBoard board{};
+    auto& occupied = bitBoards_.occupied();
+    for (int i = 0; i < obs_Moves.count; ++i)
+        if (!occupied.test(obs_Moves.obs[i])) // 该位置无棋子
+            board.set(obs_Moves.tos[i]);
+    return board;
 }
 
-vector<SSeat> Seats::getCannonMoveSeats(const SSeat& fseat) const
+BitBoard Seats::__getRook_MoveBoard(int index) const
 {
-    return __getMoveSeats(__getCannon_MoveRowcols(fseat), fseat);
+    BitBoard board{};
+    auto& occupied = bitBoards_.occupied();
+    auto& lines = SeatManager::getRookCannonMove_Lines(index);
+    for (int line = 0; line < 4; ++line)
+        for (int i = 0; i < lines.count[line]; ++i) {
+            int tindex{ lines.tos[line][i] };
+            board.set(tindex);
+            if (occupied.test(tindex)) // 该位置有棋子
+                break;
+        }
+    return board;
 }
 
-vector<SSeat> Seats::getPawnMoveSeats(bool isBottom, const SSeat& fseat) const
+BitBoard Seats::__getCannon_MoveBoard(int index) const
 {
-    return __getMoveSeats(SeatManager::getPawnMoveRowcols(isBottom, fseat->row(), fseat->col()), fseat);
+    BitBoard board{};
+    auto& occupied = bitBoards_.occupied();
+    auto& lines = SeatManager::getRookCannonMove_Lines(index);
+    for (int line = 0; line < 4; ++line) {
+        bool isSkip = false; // 是否已跳棋子的标志
+        for (int i = 0; i < lines.count[line]; ++i) {
+            int tindex{ lines.tos[line][i] };
+            if (!isSkip) {
+                if (!occupied.test(tindex)) // 该位置无棋子
+                    board.set(tindex);
+                else
+                    isSkip = true;
+            } else if (occupied.test(tindex)) { // 该位置有棋子
+                board.set(tindex);
+                break;
+            }
+        }
+    }
+    return board;
 }
 
-vector<SSeat> Seats::__getMoveSeats(const RowCol_pair_vector& rowcol_pairs, const SSeat& fseat) const
+void SeatManager::movBack(SSeat& fseat, SSeat& tseat, const SPiece& eatPiece)
 {
-    vector<SSeat> seats{};
-    for (auto& rowcol_pair : rowcol_pairs) {
-        auto& seat = getSeat(rowcol_pair);
-        if (!fseat || !fseat->isSameColor(seat)) // fseat为空 或 非同一颜色
-            seats.push_back(seat);
-    }
-    return seats;
+    tseat->movTo(fseat, eatPiece);
 }
 
-const RowCol_pair_vector
-Seats::__getNonObs_MoveRowcols(bool isBottom, const SSeat& fseat,
-    const PRowCol_pair_vector getObs_MoveRowcols(bool, int, int)) const
+// 固定种子生成，保证各次运行、各平台键值一致
+static const vector<ZobristKey>& getZobristTable()
 {
-    RowCol_pair_vector rowcols{};
-    auto& obs_MoveRowcols = getObs_MoveRowcols(isBottom, fseat->row(), fseat->col());
-    for_each(obs_MoveRowcols.begin(), obs_MoveRowcols.end(),
-        [&](const PRowCol_pair& obs_Moverowcol) {
-            if (!getSeat(obs_Moverowcol.first)->piece()) // 该位置无棋子
-                rowcols.push_back(obs_Moverowcol.second);
-        });
-    return rowcols;
+    static const vector<ZobristKey> table = []() {
+        mt19937_64 engine{ 0x20190501ULL };
+        vector<ZobristKey> keys(2 * 7 * SEATNUM + 1);
+        for (auto& key : keys)
+            key = engine();
+        return keys;
+    }();
+    return table;
 }
 
-const RowCol_pair_vector
-Seats::__getRook_MoveRowcols(const SSeat& fseat) const
+ZobristKey SeatManager::getZobrist(const SPiece& piece, int index)
 {
-    RowCol_pair_vector rowcols{};
-    for (auto& rowcolpair_Line :
-        SeatManager::getRookCannonMoveRowcol_Lines(fseat->row(), fseat->col())) {
-        for (auto& rowcol_pair : rowcolpair_Line) {
-            rowcols.push_back(rowcol_pair);
-            if (getSeat(rowcol_pair)->piece()) // 该位置有棋子
-                break;
-        }
-    }
-    return rowcols;
+    return piece ? getZobristTable()[(static_cast<int>(piece->color()) * 7
+                                         + static_cast<int>(piece->kind()))
+                                            * SEATNUM
+                                        + index]
+                 : 0;
 }
 
-const RowCol_pair_vector
-Seats::__getCannon_MoveRowcols(const SSeat& fseat) const
+ZobristKey SeatManager::getZobristSide()
 {
-    RowCol_pair_vector rowcols{};
-    for (auto& rowcolpair_Line :
-        SeatManager::getRookCannonMoveRowcol_Lines(fseat->row(), fseat->col())) {
-        bool isSkip = false; // 是否已跳棋子的标志
-        for (auto& rowcol_pair : rowcolpair_Line) {
-            auto& piece = getSeat(rowcol_pair)->piece();
-            if (!isSkip) {
-                if (!piece) // 该位置无棋子
-                    rowcols.push_back(rowcol_pair);
-                else
-                    isSkip = true;
-            } else if (piece) { // 该位置有棋子
-                rowcols.push_back(rowcol_pair);
-                break;
-            }
-        }
-    }
-    return rowcols;
+    return getZobristTable().back();
 }
 
 const RowCol_pair_vector SeatManager::getRowCols(const SSeat_vector& seats)
@@ -378,115 +756,163 @@ const RowCol_pair_vector SeatManager::getPawnRowcols(bool isBottom)
     return rowcols;
 }
 
-const RowCol_pair_vector
-SeatManager::getKingMoveRowcols(bool isBottom, int frow, int fcol)
+constexpr bool SeatManager::__isValid(int row, int col)
 {
-    RowCol_pair_vector rowcols{
-        { frow, fcol - 1 }, { frow, fcol + 1 },
-        { frow - 1, fcol }, { frow + 1, fcol }
-    };
-    int rowLow{ isBottom ? RowLowIndex_ : RowUpMidIndex_ },
-        rowUp{ isBottom ? RowLowMidIndex_ : RowUpIndex_ };
-    auto pos = remove_if(rowcols.begin(), rowcols.end(),
-        [&](const pair<int, int>& rowcol) {
-            return !(rowcol.first >= rowLow && rowcol.first <= rowUp
-                && rowcol.second >= ColMidLowIndex_ && rowcol.second <= ColMidUpIndex_);
-        });
-    return RowCol_pair_vector{ rowcols.begin(), pos };
+    return row >= RowLowIndex_ && row <= RowUpIndex_ && col >= ColLowIndex_ && col <= ColUpIndex_;
 }
 
-const RowCol_pair_vector
-SeatManager::getAdvisorMoveRowcols(bool isBottom, int frow, int fcol)
+constexpr bool SeatManager::__isPalace(bool isBottom, int row, int col)
 {
-    RowCol_pair_vector rowcols{
-        { frow - 1, fcol - 1 }, { frow - 1, fcol + 1 },
-        { frow + 1, fcol - 1 }, { frow + 1, fcol + 1 }
-    };
-    int rowLow{ isBottom ? RowLowIndex_ : RowUpMidIndex_ },
-        rowUp{ isBottom ? RowLowMidIndex_ : RowUpIndex_ };
-    auto pos = remove_if(rowcols.begin(), rowcols.end(),
-        [&](const pair<int, int>& rowcol) {
-            return !(rowcol.first >= rowLow && rowcol.first <= rowUp
-                && rowcol.second >= ColMidLowIndex_ && rowcol.second <= ColMidUpIndex_);
-        });
-    return RowCol_pair_vector{ rowcols.begin(), pos };
+    return (isBottom ? (row >= RowLowIndex_ && row <= RowLowMidIndex_)
+                     : (row >= RowUpMidIndex_ && row <= RowUpIndex_))
+        && col >= ColMidLowIndex_ && col <= ColMidUpIndex_;
 }
 
-const PRowCol_pair_vector
-SeatManager::getBishopObs_MoveRowcols(bool isBottom, int frow, int fcol)
+constexpr bool SeatManager::__isSide(bool isBottom, int row)
 {
-    PRowCol_pair_vector obs_MoveRowcols{
-        { { frow - 1, fcol - 1 }, { frow - 2, fcol - 2 } },
-        { { frow - 1, fcol + 1 }, { frow - 2, fcol + 2 } },
-        { { frow + 1, fcol - 1 }, { frow + 2, fcol - 2 } },
-        { { frow + 1, fcol + 1 }, { frow + 2, fcol + 2 } }
-    };
-    int rowLow{ isBottom ? RowLowIndex_ : RowUpLowIndex_ },
-        rowUp{ isBottom ? RowLowUpIndex_ : RowUpIndex_ };
-    auto pos = remove_if(obs_MoveRowcols.begin(), obs_MoveRowcols.end(),
-        [&](const PRowCol_pair& obs_Moverowcol) {
-            return (obs_Moverowcol.first.first < rowLow
-                || obs_Moverowcol.first.first > rowUp
-                || obs_Moverowcol.first.second < ColLowIndex_
-                || obs_Moverowcol.first.second > ColUpIndex_);
-        });
-    return PRowCol_pair_vector{ obs_MoveRowcols.begin(), pos };
+    return isBottom ? (row >= RowLowIndex_ && row <= RowLowUpIndex_)
+                    : (row >= RowUpLowIndex_ && row <= RowUpIndex_);
+}
+
+constexpr SeatTable<BitBoard, 2> SeatManager::__getKingMoves()
+{
+    SeatTable<BitBoard, 2> table{};
+    constexpr int dirs[4][2]{ { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+    for (int side = 0; side < 2; ++side)
+        for (int frow = RowLowIndex_; frow <= RowUpIndex_; ++frow)
+            for (int fcol = ColLowIndex_; fcol <= ColUpIndex_; ++fcol)
+                if (__isPalace(side, frow, fcol))
+                    for (auto& dir : dirs)
+                        if (__isPalace(side, frow + dir[0], fcol + dir[1]))
+                            table.items[side][getIndex_rc(frow, fcol)].set(getIndex_rc(frow + dir[0], fcol + dir[1]));
+    return table;
+}
+
+constexpr SeatTable<BitBoard, 2> SeatManager::__getAdvisorMoves()
+{
+    SeatTable<BitBoard, 2> table{};
+    constexpr int dirs[4][2]{ { -1, -1 }, { -1, 1 }, { 1, -1 }, { 1, 1 } };
+    for (int side = 0; side < 2; ++side)
+        for (int frow = RowLowIndex_; frow <= RowUpIndex_; ++frow)
+            for (int fcol = ColLowIndex_; fcol <= ColUpIndex_; ++fcol)
+                if (__isPalace(side, frow, fcol))
+                    for (auto& dir : dirs)
+                        if (__isPalace(side, frow + dir[0], fcol + dir[1]))
+                            table.items[side][getIndex_rc(frow, fcol)].set(getIndex_rc(frow + dir[0], fcol + dir[1]));
+    return table;
+}
+
+constexpr SeatTable<BitBoard, 2> SeatManager::__getPawnMoves()
+{
+    SeatTable<BitBoard, 2> table{};
+    for (int side = 0; side < 2; ++side)
+        for (int frow = RowLowIndex_; frow <= RowUpIndex_; ++frow)
+            for (int fcol = ColLowIndex_; fcol <= ColUpIndex_; ++fcol) {
+                auto& board = table.items[side][getIndex_rc(frow, fcol)];
+                int trow{ side ? frow + 1 : frow - 1 };
+                if (__isValid(trow, fcol))
+                    board.set(getIndex_rc(trow, fcol));
+                if (!__isSide(side, frow)) { // 兵已过河
+                    if (__isValid(frow, fcol - 1))
+                        board.set(getIndex_rc(frow, fcol - 1));
+                    if (__isValid(frow, fcol + 1))
+                        board.set(getIndex_rc(frow, fcol + 1));
+                }
+            }
+    return table;
+}
+
+constexpr SeatTable<ObsMoves, 2> SeatManager::__getBishopObs_Moves()
+{
+    SeatTable<ObsMoves, 2> table{};
+    constexpr int dirs[4][2]{ { -1, -1 }, { -1, 1 }, { 1, -1 }, { 1, 1 } };
+    for (int side = 0; side < 2; ++side)
+        for (int frow = RowLowIndex_; frow <= RowUpIndex_; ++frow)
+            for (int fcol = ColLowIndex_; fcol <= ColUpIndex_; ++fcol) {
+                auto& obs_Moves = table.items[side][getIndex_rc(frow, fcol)];
+                for (auto& dir : dirs) {
+                    int trow{ frow + dir[0] * 2 }, tcol{ fcol + dir[1] * 2 };
+                    if (__isValid(trow, tcol) && __isSide(side, trow)) { // 象不过河
+                        obs_Moves.obs[obs_Moves.count] = getIndex_rc(frow + dir[0], fcol + dir[1]);
+                        obs_Moves.tos[obs_Moves.count++] = getIndex_rc(trow, tcol);
+                    }
+                }
+            }
+    return table;
 }
 
-const PRowCol_pair_vector
-SeatManager::getKnightObs_MoveRowcols(bool isBottom, int frow, int fcol)
+constexpr SeatTable<ObsMoves, 1> SeatManager::__getKnightObs_Moves()
 {
-    PRowCol_pair_vector obs_MoveRowcols{
-        { { frow - 1, fcol }, { frow - 2, fcol - 1 } },
-        { { frow - 1, fcol }, { frow - 2, fcol + 1 } },
-        { { frow, fcol - 1 }, { frow - 1, fcol - 2 } },
-        { { frow, fcol + 1 }, { frow - 1, fcol + 2 } },
-        { { frow, fcol - 1 }, { frow + 1, fcol - 2 } },
-        { { frow, fcol + 1 }, { frow + 1, fcol + 2 } },
-        { { frow + 1, fcol }, { frow + 2, fcol - 1 } },
-        { { frow + 1, fcol }, { frow + 2, fcol + 1 } }
+    SeatTable<ObsMoves, 1> table{};
+    constexpr int legs[8][4]{ // 马腿行列偏移，目标行列偏移
+        { -1, 0, -2, -1 }, { -1, 0, -2, 1 }, { 0, -1, -1, -2 }, { 0, 1, -1, 2 },
+        { 0, -1, 1, -2 }, { 0, 1, 1, 2 }, { 1, 0, 2, -1 }, { 1, 0, 2, 1 }
     };
-    auto pos = remove_if(obs_MoveRowcols.begin(), obs_MoveRowcols.end(),
-        [&](const PRowCol_pair& obs_Moverowcol) {
-            return (obs_Moverowcol.first.first < RowLowIndex_
-                || obs_Moverowcol.first.first > RowUpIndex_
-                || obs_Moverowcol.first.second < ColLowIndex_
-                || obs_Moverowcol.first.second > ColUpIndex_);
-        });
-    return PRowCol_pair_vector{ obs_MoveRowcols.begin(), pos };
+    for (int frow = RowLowIndex_; frow <= RowUpIndex_; ++frow)
+        for (int fcol = ColLowIndex_; fcol <= ColUpIndex_; ++fcol) {
+            auto& obs_Moves = table.items[0][getIndex_rc(frow, fcol)];
+            for (auto& leg : legs) {
+                int trow{ frow + leg[2] }, tcol{ fcol + leg[3] };
+                if (__isValid(trow, tcol)) { // 目标在界内，则马腿必在界内
+                    obs_Moves.obs[obs_Moves.count] = getIndex_rc(frow + leg[0], fcol + leg[1]);
+                    obs_Moves.tos[obs_Moves.count++] = getIndex_rc(trow, tcol);
+                }
+            }
+        }
+    return table;
 }
 
-const vector<RowCol_pair_vector>
-SeatManager::getRookCannonMoveRowcol_Lines(int frow, int fcol)
+constexpr SeatTable<LineMoves, 1> SeatManager::__getRookCannonMove_Lines()
 {
-    vector<RowCol_pair_vector> rowcol_Lines(4);
-    for (int col = fcol - 1; col >= ColLowIndex_; --col)
-        rowcol_Lines[0].emplace_back(frow, col);
-    for (int col = fcol + 1; col <= ColUpIndex_; ++col)
-        rowcol_Lines[1].emplace_back(frow, col);
-    for (int row = frow - 1; row >= RowLowIndex_; --row)
-        rowcol_Lines[2].emplace_back(row, fcol);
-    for (int row = frow + 1; row <= RowUpIndex_; ++row)
-        rowcol_Lines[3].emplace_back(row, fcol);
-    return rowcol_Lines;
+    SeatTable<LineMoves, 1> table{};
+    constexpr int dirs[4][2]{ { 0, -1 }, { 0, 1 }, { -1, 0 }, { 1, 0 } };
+    for (int frow = RowLowIndex_; frow <= RowUpIndex_; ++frow)
+        for (int fcol = ColLowIndex_; fcol <= ColUpIndex_; ++fcol) {
+            auto& lines = table.items[0][getIndex_rc(frow, fcol)];
+            for (int line = 0; line < 4; ++line)
+                for (int trow = frow + dirs[line][0], tcol = fcol + dirs[line][1];
+                     __isValid(trow, tcol); trow += dirs[line][0], tcol += dirs[line][1])
+                    lines.tos[line][lines.count[line]++] = getIndex_rc(trow, tcol);
+        }
+    return table;
 }
 
-const RowCol_pair_vector
-SeatManager::getPawnMoveRowcols(bool isBottom, int frow, int fcol)
+constexpr SeatTable<ObsMoves, 1> SeatManager::__getKnightObs_Attacks()
 {
-    RowCol_pair_vector rowcols{};
-    int row{}, col{};
-    if ((isBottom && (row = frow + 1) <= RowUpIndex_)
-        || (!isBottom && (row = frow - 1) >= RowLowIndex_))
-        rowcols.emplace_back(row, fcol);
-    if (isBottom == (frow > RowLowUpIndex_)) { // 兵已过河
-        if ((col = fcol - 1) >= ColLowIndex_)
-            rowcols.emplace_back(frow, col);
-        if ((col = fcol + 1) <= ColUpIndex_)
-            rowcols.emplace_back(frow, col);
+    SeatTable<ObsMoves, 1> table{};
+    auto knightObs_Moves = __getKnightObs_Moves();
+    for (int findex = 0; findex < SEATNUM; ++findex) {
+        auto& obs_Moves = knightObs_Moves.items[0][findex];
+        for (int i = 0; i < obs_Moves.count; ++i) {
+            auto& obs_Attacks = table.items[0][obs_Moves.tos[i]];
+            obs_Attacks.obs[obs_Attacks.count] = obs_Moves.obs[i];
+            obs_Attacks.tos[obs_Attacks.count++] = findex;
+        }
     }
-    return rowcols;
-}
+    return table;
+}
+
+constexpr SeatTable<BitBoard, 2> SeatManager::__getPawnAttacks()
+{
+    SeatTable<BitBoard, 2> table{};
+    auto pawnMoves = __getPawnMoves();
+    for (int side = 0; side < 2; ++side)
+        for (int findex = 0; findex < SEATNUM; ++findex)
+            for (int tindex = 0; tindex < SEATNUM; ++tindex)
+                if (pawnMoves.items[side][findex].test(tindex))
+                    table.items[side][tindex].set(findex);
+    return table;
+}
+
+// 以常量表达式初始化，表格在编译期生成
+const SeatTable<BitBoard, 2> SeatManager::kingMoves_ = SeatManager::__getKingMoves();
+const SeatTable<BitBoard, 2> SeatManager::advisorMoves_ = SeatManager::__getAdvisorMoves();
+const SeatTable<BitBoard, 2> SeatManager::pawnMoves_ = SeatManager::__getPawnMoves();
+const SeatTable<ObsMoves, 2> SeatManager::bishopObs_Moves_ = SeatManager::__getBishopObs_Moves();
+const SeatTable<ObsMoves, 1> SeatManager::knightObs_Moves_ = SeatManager::__getKnightObs_Moves();
+const SeatTable<LineMoves, 1> SeatManager::rookCannonMove_Lines_ = SeatManager::__getRookCannonMove_Lines();
+const SeatTable<ObsMoves, 1> SeatManager::knightObs_Attacks_ = SeatManager::__getKnightObs_Attacks();
+const SeatTable<BitBoard, 2> SeatManager::pawnAttacks_ = SeatManager::__getPawnAttacks();
 /* ===== Seats end. ===== */
 
 const wstring getSeatsStr(const vector<SSeat>& seats)
@@ -2,19 +2,127 @@
 #ifndef SEAT_H
 #define SEAT_H
 
+#include "BitBoard.h"
 #include "ChessType.h"
+#include "Evaluate.h"
+#include "Mailbox.h"
+#include "Nnue.h"
 
 namespace SeatSpace {
 
+// 马、象在某位置的走子表项：阻挡位置（马腿、象眼）及其对应的目标位置
+struct ObsMoves {
+    int count;
+    int obs[8];
+    int tos[8];
+};
+
+// 车、炮在某位置的走子表项：左、右、下、上四个方向由近及远的位置
+struct LineMoves {
+    int count[4];
+    int tos[4][BOARDROWNUM - 1];
+};
+
+// 按位置序号索引的编译期走子表，SideNum为2时再按是否底方(1:底方)索引
+template <typename T, int SideNum>
+struct SeatTable {
+    T items[SideNum][SEATNUM];
+};
+
+// 一方将帅的受攻击信息：每个局面计算一次，供合法着法生成使用
+struct CheckInfo {
+    PieceColor color; // 本方颜色
+    int kingIndex;
+    bool isChecked; // 是否正被将军
+    // 牵制线：将帅位置四个方向中，前两个棋子里有对方车（将帅对面）或前三个棋子里有对方炮的方向，
+    // 记录由将帅至第二个棋子的位置；起止位置在线上的着法（牵制子、炮架移动或插入）须检验该方向
+    BitBoard pinBoards[4];
+    BitBoard legBoard; // 对方可攻击将帅的马的马腿位置，马腿上的棋子除吃该马外不能移动
+};
+
+// 着法表类：栈上定长存放，不分配堆内存（一个局面的着法数少于128）
+class MoveList {
+
+public:
+    static constexpr int MaxNum{ 128 };
+
+    static constexpr MoveCode getMove(int findex, int tindex)
+    {
+        return static_cast<MoveCode>(findex | (tindex << 7));
+    }
+    static constexpr int fromIndex(MoveCode move) { return move & 0x7F; }
+    static constexpr int toIndex(MoveCode move) { return move >> 7; }
+
+    void add(int findex, int tindex)
+    {
+        assert(count_ < MaxNum);
+        moves_[count_++] = getMove(findex, tindex);
+    }
+    // 由第start个着法起，删除满足pred的着法（保持原有顺序）
+    template <typename Pred>
+    void removeIf(int start, Pred pred)
+    {
+        count_ = static_cast<int>(remove_if(moves_ + start, moves_ + count_, pred) - moves_);
+    }
+    // 将第index个着法移至最前，其余着法顺序不变（供着法排序）
+    void moveToFront(int index, int front = 0)
+    {
+        rotate(moves_ + front, moves_ + index, moves_ + index + 1);
+    }
+    void swap(int index1, int index2) { std::swap(moves_[index1], moves_[index2]); }
+    void clear() { count_ = 0; }
+
+    int size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+    MoveCode operator[](int index) const { return moves_[index]; }
+    const MoveCode* begin() const { return moves_; }
+    const MoveCode* end() const { return moves_ + count_; }
+
+private:
+    MoveCode moves_[MaxNum];
+    int count_{ 0 };
+};
+
+// 棋子位置序号表类：按颜色、种类记录棋子所在位置（表内无序），随走子增量更新
+class PieceLists {
+
+public:
+    int count(PieceColor color, PieceKind kind) const
+    {
+        return counts_[static_cast<int>(color)][static_cast<int>(kind)];
+    }
+    const int* indexs(PieceColor color, PieceKind kind) const
+    {
+        return indexs_[static_cast<int>(color)][static_cast<int>(kind)];
+    }
+    // 将帅所在位置，不在棋盘上则返回-1
+    int kingIndex(PieceColor color) const
+    {
+        return count(color, PieceKind::KING) ? indexs(color, PieceKind::KING)[0] : -1;
+    }
+
+    void put(PieceColor color, PieceKind kind, int index);
+    void remove(PieceColor color, PieceKind kind, int index);
+    void clear();
+
+private:
+    static constexpr int KindMaxNum_{ 5 }; // 同种棋子最多5个（兵）
+
+    int indexs_[2][7][KindMaxNum_]{};
+    int counts_[2][7]{};
+    int listIndexs_[SEATNUM]{}; // 各位置在所属表中的序号，用于常数时间删除
+};
+
 // 棋子位置类
 class Seat : public enable_shared_from_this<Seat> {
 
 public:
-    explicit Seat(int row, int col);
+    explicit Seat(int row, int col, Seats* seats = nullptr);
 
     int row() const { return row_; }
     int col() const { return col_; }
     int rowcol() const { return row_ * 10 + col_; }
+    int index() const { return row_ * BOARDCOLNUM + col_; }
     const SPiece& piece() const { return piece_; }
 
     bool isSameColor(const SSeat& seat) const;
@@ -26,23 +134,66 @@ public:
 private:
     const int row_, col_;
     SPiece piece_{};
+    Seats* const seats_; // 所属棋盘位置，走子时同步其增量信息
 };
 
 // 棋盘位置类
 class Seats {
+    friend class Seat;
+
 public:
     Seats();
+    Seats(const Seats&) = delete;
+    Seats& operator=(const Seats&) = delete;
 
     const SSeat& getSeat(int row, int col) const;
     const SSeat& getSeat(int rowcol) const;
     const SSeat& getSeat(RowCol_pair rowcol_pair) const;
+    const SSeat& getIndexSeat(int index) const { return allSeats_[index]; }
 
     const SSeat& getKingSeat(bool isBottom) const;
+    int getKingIndex(bool isBottom) const;
+    // 局面的Zobrist键值（含走子方：每走一步或退回一步均切换）
+    ZobristKey key() const { return key_; }
+    // 按颜色、种类记录的位棋盘，随走子增量更新
+    const BitBoards& bitBoards() const { return bitBoards_; }
+    // 按颜色、种类记录的棋子位置序号表，随走子增量更新
+    const PieceLists& pieceLists() const { return pieceLists_; }
+    // 填充信箱棋盘（单字节棋子代码），随走子增量更新，可供各线程低成本复制
+    const Mailbox& mailbox() const { return mailbox_; }
+    // 双方子力及位置价值，随走子增量更新
+    const Evaluation& evaluation() const { return evaluation_; }
+    // 神经网络评估的第一层累加器，已载入网络时随走子增量更新
+    const Accumulator& accumulator() const { return accumulator_; }
 
     // 棋子可放置的位置
     SSeat_vector getPutSeats(bool isBottom, const SPiece& piece) const;
     // 某位置棋子可移动的位置（未排除被将军的情况）
     SSeat_vector getMoveSeats(bool isBottom, const SSeat& fseat) const;
+    // 某位置某种棋子可到达的位置（含本方棋子占据的位置，未排除被将军的情况）
+    BitBoard getMoveBoard(bool isBottom, PieceKind kind, int index) const;
+    // 以下模板按是否底方(IsBottom)生成两个无分支的实例，由调用者按局面选用其一
+    template <bool IsBottom>
+    BitBoard getMoveBoard(PieceKind kind, int index) const;
+    // color方（IsBottom为其是否底方）全部棋子的吃子（isCapture为真）或不吃子着法，追加至moves（未排除被将军的情况）
+    template <bool IsBottom>
+    void getMoves(MoveList& moves, PieceColor color, bool isCapture) const;
+    // 位于index的棋子的吃子或不吃子着法，追加至moves（未排除被将军的情况）
+    template <bool IsBottom>
+    void getMoves(MoveList& moves, int index, bool isCapture) const;
+    // color方（isBottom为其是否底方）的车马炮兵、将（对面）是否可攻击index位置：由该位置向外反向查找
+    bool isAttacked(PieceColor color, bool isBottom, int index) const;
+    template <bool IsBottom>
+    bool isAttacked(PieceColor color, int index) const;
+    // color方（isBottom为其是否底方）将帅的受攻击信息
+    CheckInfo getCheckInfo(PieceColor color, bool isBottom) const;
+    template <bool IsBottom>
+    CheckInfo getCheckInfo(PieceColor color) const;
+    // 未被将军时，非将帅棋子由findex走至tindex后本方是否不被将军（无须走子）
+    bool isLegalMove(const CheckInfo& checkInfo, int findex, int tindex) const;
+    // 静态交换评估(SEE)：color方（isBottom为其是否底方）由findex吃tindex，双方轮流以最小价值棋子吃回的子力得失
+    // 每次吃子后按剩余棋子重新查找攻击者：炮架增减、被移开的棋子后方显露的车炮均计入（未考虑牵制）
+    int see(PieceColor color, bool isBottom, int findex, int tindex) const;
     // 取得棋盘上活的棋子
     SSeat_vector getLiveSeats(PieceColor color, wchar_t name = BLANKNAME,
         int col = BLANKCOL, bool getStronge = false) const;
@@ -56,6 +207,16 @@ public:
 
 private:
     SSeat_vector allSeats_{};
+    BitBoards bitBoards_{};
+    PieceLists pieceLists_{};
+    Mailbox mailbox_{};
+    Evaluation evaluation_{};
+    Accumulator accumulator_{};
+    ZobristKey key_{ 0 };
+
+    // 棋子由fseat移至tseat(原有tpiece)、fseat放置eatPiece之前，增量更新位棋盘、位置序号表、信箱棋盘、评估值、累加器和键值
+    void __movTo(const Seat& fseat, const Seat& tseat, const SPiece& tpiece, const SPiece& eatPiece);
+    ZobristKey __getKey() const;
 
     SSeat_vector getAllSeats() const;
     SSeat_vector getKingSeats(bool isBottom) const;
@@ -63,34 +224,33 @@ private:
     SSeat_vector getBishopSeats(bool isBottom) const;
     SSeat_vector getPawnSeats(bool isBottom) const;
 
-    SSeat_vector getKingMoveSeats(bool isBottom, const SSeat& fseat) const;
-    SSeat_vector getAdvisorMoveSeats(bool isBottom, const SSeat& fseat) const;
-    SSeat_vector getBishopMoveSeats(bool isBottom, const SSeat& fseat) const;
-    SSeat_vector getKnightMoveSeats(bool isBottom, const SSeat& fseat) const;
-    SSeat_vector getRookMoveSeats(const SSeat& fseat) const;
-    SSeat_vector getCannonMoveSeats(const SSeat& fseat) const;
-    SSeat_vector getPawnMoveSeats(bool isBottom, const SSeat& fseat) const;
-
-    // 排除同颜色棋子，fseat为空则无需排除
-    SSeat_vector __getMoveSeats(const RowCol_pair_vector& rowcols, const SSeat& fseat = nullptr) const;
-
-    const RowCol_pair_vector __getNonObs_MoveRowcols(bool isBottom, const SSeat& fseat,
-        const PRowCol_pair_vector getObs_MoveRowcols(bool, int, int)) const;
-    const RowCol_pair_vector __getRook_MoveRowcols(const SSeat& fseat) const;
-    const RowCol_pair_vector __getCannon_MoveRowcols(const SSeat& fseat) const;
+    SSeat_vector __getSeats(const RowCol_pair_vector& rowcols) const;
+    SSeat_vector __getSeats(BitBoard board) const;
+
+    template <bool IsBottom>
+    void __addMoves(MoveList& moves, PieceColor color, PieceKind kind, int index, bool isCapture) const;
+    // 按occupied中的棋子，color方可吃index位置的最小价值棋子所在位置，无则返回-1
+    int __getLeastAttacker(PieceColor color, bool isBottom, int index, const BitBoard& occupied, PieceKind& kind) const;
+    BitBoard __getNonObs_MoveBoard(const ObsMoves& obs_Moves) const;
+    BitBoard __getRook_MoveBoard(int index) const;
+    BitBoard __getCannon_MoveBoard(int index) const;
 };
 
 // 棋盘位置管理类
 class SeatManager {
 public:
     static bool isBottom(int row) { return row < RowLowUpIndex_; };
-    static int getIndex_rc(int row, int col) { return row * BOARDCOLNUM + col; }
+    static constexpr int getIndex_rc(int row, int col) { return row * BOARDCOLNUM + col; }
     static int getIndex_rc(int rowcol) { return getIndex_rc(rowcol / 10, rowcol % 10); }
     static int getRotate(int rowcol) { return (BOARDROWNUM - rowcol / 10 - 1) * 10 + (BOARDCOLNUM - rowcol % 10 - 1); }
     static int getSymmetry(int rowcol) { return rowcol + BOARDCOLNUM - rowcol % 10 * 2 - 1; }
 
     static void movBack(SSeat& fseat, SSeat& tseat, const SPiece& eatPiece);
 
+    // 棋子在某位置的Zobrist随机值，piece为空则为0
+    static ZobristKey getZobrist(const SPiece& piece, int index);
+    static ZobristKey getZobristSide();
+
     static const RowCol_pair_vector getRowCols(const SSeat_vector& seats);
 
     static const RowCol_pair_vector getAllRowcols();
@@ -99,17 +259,39 @@ public:
     static const RowCol_pair_vector getBishopRowcols(bool isBottom);
     static const RowCol_pair_vector getPawnRowcols(bool isBottom);
 
-    static const RowCol_pair_vector getKingMoveRowcols(bool isBottom, int frow, int fcol);
-    static const RowCol_pair_vector getAdvisorMoveRowcols(bool isBottom, int frow, int fcol);
-    static const PRowCol_pair_vector getBishopObs_MoveRowcols(bool isBottom, int frow, int fcol);
-    static const PRowCol_pair_vector getKnightObs_MoveRowcols(bool isBottom, int frow, int fcol);
-    static const vector<RowCol_pair_vector> getRookCannonMoveRowcol_Lines(int frow, int fcol);
-    static const RowCol_pair_vector getPawnMoveRowcols(bool isBottom, int frow, int fcol);
+    // 编译期生成的走子表（未排除阻挡及本方棋子），走子时无需分配内存
+    static const BitBoard& getKingMoveBoard(bool isBottom, int index) { return kingMoves_.items[isBottom][index]; }
+    static const BitBoard& getAdvisorMoveBoard(bool isBottom, int index) { return advisorMoves_.items[isBottom][index]; }
+    static const BitBoard& getPawnMoveBoard(bool isBottom, int index) { return pawnMoves_.items[isBottom][index]; }
+    static const ObsMoves& getBishopObs_Moves(bool isBottom, int index) { return bishopObs_Moves_.items[isBottom][index]; }
+    static const ObsMoves& getKnightObs_Moves(int index) { return knightObs_Moves_.items[0][index]; }
+    static const LineMoves& getRookCannonMove_Lines(int index) { return rookCannonMove_Lines_.items[0][index]; }
+    // 反向走子表：可攻击某位置的马所在位置及其马腿，可攻击某位置的兵（isBottom为兵方）所在位置
+    static const ObsMoves& getKnightObs_Attacks(int index) { return knightObs_Attacks_.items[0][index]; }
+    static const BitBoard& getPawnAttackBoard(bool isBottom, int index) { return pawnAttacks_.items[isBottom][index]; }
 
 private:
     static constexpr int RowLowIndex_{ 0 }, RowLowMidIndex_{ 2 }, RowLowUpIndex_{ 4 },
         RowUpLowIndex_{ 5 }, RowUpMidIndex_{ 7 }, RowUpIndex_{ 9 },
         ColLowIndex_{ 0 }, ColMidLowIndex_{ 3 }, ColMidUpIndex_{ 5 }, ColUpIndex_{ 8 };
+
+    static constexpr bool __isValid(int row, int col);
+    static constexpr bool __isPalace(bool isBottom, int row, int col);
+    static constexpr bool __isSide(bool isBottom, int row);
+
+    static constexpr SeatTable<BitBoard, 2> __getKingMoves();
+    static constexpr SeatTable<BitBoard, 2> __getAdvisorMoves();
+    static constexpr SeatTable<BitBoard, 2> __getPawnMoves();
+    static constexpr SeatTable<ObsMoves, 2> __getBishopObs_Moves();
+    static constexpr SeatTable<ObsMoves, 1> __getKnightObs_Moves();
+    static constexpr SeatTable<LineMoves, 1> __getRookCannonMove_Lines();
+    static constexpr SeatTable<ObsMoves, 1> __getKnightObs_Attacks();
+    static constexpr SeatTable<BitBoard, 2> __getPawnAttacks();
+
+    static const SeatTable<BitBoard, 2> kingMoves_, advisorMoves_, pawnMoves_, pawnAttacks_;
+    static const SeatTable<ObsMoves, 2> bishopObs_Moves_;
+    static const SeatTable<ObsMoves, 1> knightObs_Moves_, knightObs_Attacks_;
+    static const SeatTable<LineMoves, 1> rookCannonMove_Lines_;
 };
 
 const wstring getSeatsStr(const SSeat_vector& seats);
@@ -0,0 +1,442 @@
+﻿#include "Tablebase.h"
+#include "Board.h"
+#include "Mailbox.h"
+#include "Piece.h"
+#include "Seat.h"
+#include "Tools.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace TablebaseSpace {
+
+// 规范组合名称中棋子字符的顺序，及各种类棋子的最多数量
+static const string PieceOrderChars{ "KABNRCPkabnrcp" };
+static constexpr int KindMaxNums[7]{ 1, 2, 2, 2, 2, 2, 5 };
+// 可攻击对方的棋子：双方均无则为和棋，无须生成（不计困毙）
+static const string AttackChars{ "NRCPnrcp" };
+// 生成时每个线程一次取得的局面数；局面总数（两方）的上限
+static constexpr long long ChunkSize{ 1 << 14 }, MaxEntryNum{ 1LL << 32 };
+
+static bool isDrawnName(const string& name)
+{
+    return name.find_first_of(AttackChars) == string::npos;
+}
+
+static string getFileName(const string& path, const string& name, const char* ext)
+{
+    return (path.empty() ? string{} : path + '/') + name + ext;
+}
+
+/* ===== MappedFile start. ===== */
+bool MappedFile::open(const string& fileName)
+{
+    close();
+#ifdef _WIN32
+    HANDLE file{ CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr) };
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER fileSize{};
+    HANDLE mapping{ GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0
+            ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)
+            : nullptr };
+    void* data{ mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr };
+    if (!data) {
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+    file_ = file;
+    mapping_ = mapping;
+    size_ = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd{ ::open(fileName.c_str(), O_RDONLY) };
+    if (fd < 0)
+        return false;
+    struct stat fileStat {
+    };
+    void* data{ fstat(fd, &fileStat) == 0 && fileStat.st_size > 0
+            ? mmap(nullptr, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0)
+            : MAP_FAILED };
+    ::close(fd); // 映射在关闭文件后仍然有效
+    if (data == MAP_FAILED)
+        return false;
+    size_ = static_cast<size_t>(fileStat.st_size);
+#endif
+    data_ = static_cast<const unsigned char*>(data);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (!data_)
+        return;
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+    CloseHandle(file_);
+#else
+    munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    mapping_ = file_ = nullptr;
+}
+/* ===== MappedFile end. ===== */
+
+/* ===== Tablebase start. ===== */
+Tablebase::Tablebase(const string& name)
+    : name_{ name }
+{
+    static const Seats seats{}; // 只用于取得各种棋子可放置的位置
+    for (char ch : name) {
+        TbPiece piece{ PieceManager::getColor(ch), PieceManager::getKindFromCh(ch), {}, {}, 0 };
+        fill(begin(piece.positions), end(piece.positions), -1);
+        for (auto& seat : seats.getPutSeats(piece.color == PieceColor::RED, make_shared<Piece>(ch))) {
+            piece.positions[seat->index()] = piece.indexs.size();
+            piece.indexs.push_back(seat->index());
+        }
+        pieces_.push_back(move(piece));
+    }
+    for (auto piece = pieces_.rbegin(); piece != pieces_.rend(); ++piece) {
+        piece->weight = size_;
+        size_ *= piece->indexs.size();
+    }
+}
+
+long long Tablebase::getIndex(const int* indexs) const
+{
+    long long index{ 0 };
+    for (size_t i = 0; i < pieces_.size(); ++i) {
+        int position{ pieces_[i].positions[indexs[i]] };
+        if (position < 0)
+            return -1;
+        index += position * pieces_[i].weight;
+    }
+    return index;
+}
+
+void Tablebase::getIndexs(long long index, int* indexs) const
+{
+    for (size_t i = 0; i < pieces_.size(); ++i) {
+        auto& piece = pieces_[i];
+        indexs[i] = piece.indexs[index / piece.weight % piece.indexs.size()];
+    }
+}
+
+bool Tablebase::load(const string& path)
+{
+    if (dtmFile_.open(getFileName(path, name_, ".dtm")) && !__checkHeader(dtmFile_, "CCTB", size_ * 2))
+        dtmFile_.close();
+    if (wdlFile_.open(getFileName(path, name_, ".wdl")) && !__checkHeader(wdlFile_, "CCTW", (size_ * 2 + 3) / 4))
+        wdlFile_.close();
+    return hasDtm() || hasWdl();
+}
+
+bool Tablebase::__checkHeader(const MappedFile& file, const char* magic, long long dataSize)
+{
+    unsigned header[3]{};
+    if (file.size() != static_cast<size_t>(HeaderSize + dataSize) || !equal(magic, magic + 4, file.data()))
+        return false;
+    copy(file.data() + 4, file.data() + HeaderSize, reinterpret_cast<unsigned char*>(header));
+    if (header[0] != 1 || header[1] != size_)
+        return false;
+    maxDtm_ = header[2];
+    return true;
+}
+/* ===== Tablebase end. ===== */
+
+/* ===== TablebaseManager start. ===== */
+atomic<bool> TablebaseManager::enabled_{ false };
+map<string, unique_ptr<Tablebase>> TablebaseManager::tables_{};
+
+void TablebaseManager::setPath(const string& path)
+{
+    enabled_ = false;
+    tables_.clear();
+    if (path.empty())
+        return;
+    // 映射目录下的全部残局库文件，之后探查时只读取对照表，无须加锁
+    vector<string> files{};
+    Tools::getFiles(path, files);
+    for (auto& fileName : files) {
+        size_t dotPos{ fileName.rfind('.') }, namePos{ fileName.find_last_of("/\\") + 1 };
+        if (dotPos == string::npos || dotPos < namePos
+            || (Tools::getExtStr(fileName) != ".dtm" && Tools::getExtStr(fileName) != ".wdl"))
+            continue;
+        string name{ fileName.substr(namePos, dotPos - namePos) };
+        if (getName(name) != name || tables_.count(name))
+            continue;
+        unique_ptr<Tablebase> tablebase{ new Tablebase(name) };
+        if (tablebase->load(path))
+            tables_.emplace(name, move(tablebase));
+    }
+    enabled_ = !tables_.empty();
+}
+
+string TablebaseManager::getName(const string& pieceChars)
+{
+    int counts[2][7]{};
+    for (char ch : pieceChars) {
+        if (PieceOrderChars.find(ch) == string::npos)
+            return string{};
+        ++counts[static_cast<int>(PieceManager::getColor(ch))][static_cast<int>(PieceManager::getKindFromCh(ch))];
+    }
+    string name{};
+    for (int color = 0; color < 2; ++color)
+        for (int kind = 0; kind < 7; ++kind) {
+            int count{ counts[color][kind] };
+            if (count > KindMaxNums[kind] || (kind == static_cast<int>(PieceKind::KING) && count != 1))
+                return string{};
+            name.append(count, PieceOrderChars[color * 7 + kind]);
+        }
+    return name.size() > Tablebase::MaxPieceNum ? string{} : name;
+}
+
+bool TablebaseManager::probe(const Board& board, PieceColor color, int& wdl, int& plies)
+{
+    wstring pieceChars{ board.getPieceChars() };
+    string chars{};
+    int boardIndexs[Tablebase::MaxPieceNum]{};
+    for (int index = 0; index < SEATNUM; ++index)
+        if (pieceChars[index] != PieceManager::nullChar()) {
+            if (chars.size() == Tablebase::MaxPieceNum)
+                return false;
+            boardIndexs[chars.size()] = index;
+            chars.push_back(static_cast<char>(pieceChars[index]));
+        }
+
+    // 残局库红方在底方：直接对照或交换双方（其一可能需旋转棋盘）
+    for (int isSwap = 0; isSwap < 2; ++isSwap) {
+        string swapChars{ chars };
+        if (isSwap)
+            for (auto& ch : swapChars)
+                ch = static_cast<char>(islower(ch) ? toupper(ch) : tolower(ch));
+        const Tablebase* tablebase{ __getTablebase(getName(swapChars)) };
+        if (!tablebase)
+            continue;
+
+        bool isRotate{ board.isBottomSide(PieceColor::RED) == (isSwap == 1) }, used[Tablebase::MaxPieceNum]{};
+        int indexs[Tablebase::MaxPieceNum]{};
+        for (size_t i = 0; i < tablebase->name().size(); ++i)
+            for (size_t j = 0; j < swapChars.size(); ++j)
+                if (!used[j] && swapChars[j] == tablebase->name()[i]) {
+                    used[j] = true;
+                    indexs[i] = isRotate ? SEATNUM - 1 - boardIndexs[j] : boardIndexs[j];
+                    break;
+                }
+        long long index{ tablebase->getIndex(indexs) };
+        bool isRed{ (color == PieceColor::RED) != (isSwap == 1) };
+        if (index < 0)
+            return false;
+        if (tablebase->hasDtm()) {
+            int value{ tablebase->dtmValue(isRed, index) };
+            if (value == Tablebase::IllegalValue)
+                return false;
+            plies = value > 0 ? value - 1 : 0;
+            wdl = value == 0 ? 0 : (plies % 2 ? 1 : -1);
+        } else {
+            int value{ tablebase->wdlValue(isRed, index) };
+            if (value == 3)
+                return false;
+            plies = -1;
+            wdl = value == 1 ? 1 : (value == 2 ? -1 : 0);
+        }
+        return true;
+    }
+    return false;
+}
+
+bool TablebaseManager::generate(const string& name, const string& path, int threadNum, bool isVerbose)
+{
+    string tbName{ getName(name) };
+    return !tbName.empty() && __generate(tbName, path, max(threadNum, 1), isVerbose);
+}
+
+const Tablebase* TablebaseManager::__getTablebase(const string& name)
+{
+    auto iter = tables_.find(name);
+    return iter == tables_.end() ? nullptr : iter->second.get();
+}
+
+bool TablebaseManager::__generate(const string& name, const string& path, int threadNum, bool isVerbose)
+{
+    Tablebase tablebase{ name };
+    if (isDrawnName(name) || (tablebase.load(path) && tablebase.hasDtm() && tablebase.hasWdl()))
+        return true;
+    long long size{ tablebase.size() }, entryNum{ size * 2 };
+    if (entryNum > MaxEntryNum) {
+        cout << name << ": too many positions (" << entryNum << ")\n";
+        return false;
+    }
+
+    // 吃去各棋子后的组合：先生成并映射其文件；双方均无攻击棋子的视为和棋
+    auto& pieces = tablebase.pieces();
+    int pieceNum = pieces.size(), subMaxDtm{ 0 };
+    vector<unique_ptr<Tablebase>> subTablebases(pieceNum);
+    vector<vector<long long>> subWeights(pieceNum, vector<long long>(pieceNum, 0));
+    for (int i = 0; i < pieceNum; ++i) {
+        if (pieces[i].kind == PieceKind::KING)
+            continue;
+        string subName{ name.substr(0, i) + name.substr(i + 1) };
+        if (isDrawnName(subName))
+            continue;
+        if (!__generate(subName, path, threadNum, isVerbose))
+            return false;
+        subTablebases[i].reset(new Tablebase(subName));
+        if (!subTablebases[i]->load(path) || !subTablebases[i]->hasDtm())
+            return false;
+        subMaxDtm = max(subMaxDtm, subTablebases[i]->maxDtm());
+        for (int k = 0; k < pieceNum; ++k)
+            if (k != i)
+                subWeights[i][k] = subTablebases[i]->pieces()[k < i ? k : k - 1].weight;
+    }
+
+    // 逐轮前向迭代：第distance轮确定距胜负恰为distance步的局面（各线程分块处理，只写入本局面）
+    // 局面值：0为未定（最终为和棋），其余同DTM文件
+    vector<atomic<unsigned char>> values(entryNum);
+    for (auto& value : values)
+        value.store(0, memory_order_relaxed);
+    auto __runPass = [&](int distance) {
+        atomic<long long> nextEntry{ 0 }, changedNum{ 0 };
+        auto __worker = [&]() {
+            Mailbox mailbox{};
+            int indexs[Tablebase::MaxPieceNum]{}, owners[SEATNUM]{};
+            long long changed{ 0 };
+            for (long long start = nextEntry.fetch_add(ChunkSize); start < entryNum; start = nextEntry.fetch_add(ChunkSize))
+                for (long long entry = start; entry < min(start + ChunkSize, entryNum); ++entry) {
+                    if (values[entry].load(memory_order_relaxed))
+                        continue;
+                    bool isRed{ entry < size };
+                    long long index{ entry % size };
+                    PieceColor color{ isRed ? PieceColor::RED : PieceColor::BLACK },
+                        othColor{ PieceManager::getOtherColor(color) };
+                    tablebase.getIndexs(index, indexs);
+                    fill(begin(owners), end(owners), -1);
+                    mailbox.clear();
+                    bool isIllegal{ false };
+                    for (int i = 0; i < pieceNum; ++i) {
+                        isIllegal = isIllegal || owners[indexs[i]] >= 0;
+                        owners[indexs[i]] = i;
+                        mailbox.put(pieces[i].color, pieces[i].kind, indexs[i]);
+                    }
+                    // 棋子重叠或对方被将军（含将帅对面）为不合法局面
+                    if (distance == 0 && (isIllegal || mailbox.isKilled(othColor, !isRed))) {
+                        values[entry].store(Tablebase::IllegalValue, memory_order_relaxed);
+                        continue;
+                    }
+
+                    MoveList moves{};
+                    mailbox.getMoves(moves, color, isRed, true);
+                    mailbox.getMoves(moves, color, isRed, false);
+                    int winMin{ INT_MAX }, lossMax{ -1 };
+                    bool hasMove{ false }, isAllWin{ true };
+                    for (auto move : moves) {
+                        int findex{ MoveList::fromIndex(move) }, tindex{ MoveList::toIndex(move) };
+                        int fsquare{ Mailbox::getSquare(findex) }, tsquare{ Mailbox::getSquare(tindex) };
+                        unsigned char eatCode{ mailbox.movTo(fsquare, tsquare) };
+                        bool isLegal{ !mailbox.isKilled(color, isRed) };
+                        mailbox.movBack(fsquare, tsquare, eatCode);
+                        if (!isLegal)
+                            continue;
+
+                        hasMove = true;
+                        int mover{ owners[findex] }, value{ 0 };
+                        if (eatCode == Mailbox::EMPTY)
+                            value = values[(isRed ? size : 0) + index
+                                + (pieces[mover].positions[tindex] - pieces[mover].positions[findex]) * pieces[mover].weight]
+                                        .load(memory_order_relaxed);
+                        else {
+                            int eaten{ owners[tindex] };
+                            auto& subTablebase = subTablebases[eaten];
+                            if (subTablebase) {
+                                long long subIndex{ 0 };
+                                for (int k = 0; k < pieceNum; ++k)
+                                    if (k != eaten)
+                                        subIndex += pieces[k].positions[k == mover ? tindex : indexs[k]] * subWeights[eaten][k];
+                                value = subTablebase->dtmValue(!isRed, subIndex);
+                            }
+                        }
+                        // 对方负则本方胜（取最短），对方全胜则本方负（取最长）
+                        if (value == 0)
+                            isAllWin = false;
+                        else if ((value - 1) % 2 == 0)
+                            winMin = min(winMin, value);
+                        else
+                            lossMax = max(lossMax, value);
+                    }
+                    int result{ !hasMove ? 0 : (winMin < INT_MAX ? winMin : (isAllWin ? lossMax : -1)) };
+                    if (result == distance) {
+                        values[entry].store(static_cast<unsigned char>(distance + 1), memory_order_relaxed);
+                        ++changed;
+                    }
+                }
+            changedNum += changed;
+        };
+        vector<thread> threads{};
+        for (int i = 1; i < threadNum; ++i)
+            threads.emplace_back(__worker);
+        __worker(); // 本线程同样参与计算
+        for (auto& th : threads)
+            th.join();
+        return changedNum.load();
+    };
+
+    auto startTime = chrono::steady_clock::now();
+    int maxDtm{ 0 };
+    long long lastChanged{ 0 };
+    bool isComplete{ false };
+    for (int distance = 0; distance < Tablebase::IllegalValue - 1; ++distance) {
+        long long changed{ __runPass(distance) };
+        if (changed > 0)
+            maxDtm = distance;
+        if (isVerbose)
+            cout << name << ": distance " << distance << ", positions " << changed << endl;
+        // 连续两轮均无变化，且吃子后的组合不会再带来更长的距离
+        if (distance > 0 && changed == 0 && lastChanged == 0 && distance > subMaxDtm + 1) {
+            isComplete = true;
+            break;
+        }
+        lastChanged = changed;
+    }
+    // 1字节的DTM值存放不下更长的距离：未确定的局面不能当作和棋写入
+    if (!isComplete) {
+        cout << name << ": dtm exceeds " << Tablebase::IllegalValue - 2 << ", not written\n";
+        return false;
+    }
+
+    // 写入DTM、WDL文件
+    unsigned header[3]{ 1, static_cast<unsigned>(size), static_cast<unsigned>(maxDtm) };
+    ofstream dtmFile(getFileName(path, name, ".dtm"), ios_base::binary), wdlFile(getFileName(path, name, ".wdl"), ios_base::binary);
+    dtmFile.write("CCTB", 4).write(reinterpret_cast<const char*>(header), sizeof(header));
+    wdlFile.write("CCTW", 4).write(reinterpret_cast<const char*>(header), sizeof(header));
+    vector<char> dtmBuffer{}, wdlBuffer{};
+    for (long long start = 0; start < entryNum; start += ChunkSize * 4) {
+        long long end{ min(start + ChunkSize * 4, entryNum) };
+        dtmBuffer.assign(end - start, 0);
+        wdlBuffer.assign((end - start + 3) / 4, 0);
+        for (long long entry = start; entry < end; ++entry) {
+            int value{ values[entry].load(memory_order_relaxed) },
+                wdl{ value == 0 ? 0 : (value == Tablebase::IllegalValue ? 3 : ((value - 1) % 2 ? 1 : 2)) };
+            dtmBuffer[entry - start] = static_cast<char>(value);
+            wdlBuffer[(entry - start) / 4] |= static_cast<char>(wdl << ((entry - start) % 4 * 2));
+        }
+        dtmFile.write(dtmBuffer.data(), dtmBuffer.size());
+        wdlFile.write(wdlBuffer.data(), wdlBuffer.size());
+    }
+    if (isVerbose)
+        cout << name << ": " << entryNum << " positions, max dtm " << maxDtm << ", "
+             << chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - startTime).count() << "ms\n";
+    return static_cast<bool>(dtmFile) && static_cast<bool>(wdlFile);
+}
+/* ===== TablebaseManager end. ===== */
+}
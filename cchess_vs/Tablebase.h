@@ -0,0 +1,117 @@
+﻿//#pragma once
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include "ChessType.h"
+
+namespace TablebaseSpace {
+
+// 只读映射的文件：Windows下为文件映射对象，其他平台为mmap
+class MappedFile {
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const string& fileName);
+    void close();
+
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const unsigned char* data_{ nullptr };
+    size_t size_{ 0 };
+    void* mapping_{ nullptr }; // Windows：文件及映射对象句柄
+    void* file_{ nullptr };
+};
+
+// 一种子力组合的残局库：红方在底方，组合以棋子字符表示（如"KRkaabb"），按红黑、将士象马车炮兵排列
+// 局面序号：各棋子在其可放置位置（Seats::getPutSeats）中的序号按混合进制组合，红方走、黑方走各一段
+// DTM文件（.dtm）：标识"CCTB"，uint32版本号1、局面数（每方）、最大步数，其后每局面1字节：
+//   0为和棋，255为不合法局面，其余为步数+1，步数为奇数时走子方胜、偶数时走子方负（0为已被将死或困毙）
+// WDL文件（.wdl）：标识"CCTW"，同样的头部，其后每局面2位（每字节4个局面，低位在前）：0和、1胜、2负、3不合法
+// 不计长将、长捉等循环规则
+class Tablebase {
+
+public:
+    static constexpr unsigned char IllegalValue{ 0xFF };
+    static constexpr int MaxPieceNum{ 7 }, HeaderSize{ 16 };
+
+    // 各棋子：颜色、种类、可放置的位置序号及位置至其序号的对照（不可放置为-1）、序号的进制权重
+    struct TbPiece {
+        PieceColor color;
+        PieceKind kind;
+        vector<int> indexs;
+        int positions[SEATNUM];
+        long long weight;
+    };
+
+    // name须为规范的组合名称（见TablebaseManager::getName）
+    explicit Tablebase(const string& name);
+
+    const string& name() const { return name_; }
+    const vector<TbPiece>& pieces() const { return pieces_; }
+    long long size() const { return size_; }
+    int maxDtm() const { return maxDtm_; }
+
+    // 各棋子所在位置 <-> 局面序号
+    long long getIndex(const int* indexs) const;
+    void getIndexs(long long index, int* indexs) const;
+
+    // 映射path目录下的DTM、WDL文件，至少一个有效则返回true
+    bool load(const string& path);
+    bool hasDtm() const { return dtmFile_.data() != nullptr; }
+    bool hasWdl() const { return wdlFile_.data() != nullptr; }
+    // 已载入文件的数据：isRed为红方走，返回DTM字节值、WDL值
+    unsigned char dtmValue(bool isRed, long long index) const
+    {
+        return dtmFile_.data()[HeaderSize + (isRed ? 0 : size_) + index];
+    }
+    int wdlValue(bool isRed, long long index) const
+    {
+        long long entry{ (isRed ? 0 : size_) + index };
+        return (wdlFile_.data()[HeaderSize + entry / 4] >> (entry % 4 * 2)) & 3;
+    }
+
+private:
+    string name_;
+    vector<TbPiece> pieces_{};
+    long long size_{ 1 };
+    int maxDtm_{ 0 };
+    MappedFile dtmFile_{}, wdlFile_{};
+
+    bool __checkHeader(const MappedFile& file, const char* magic, long long dataSize);
+};
+
+// 残局库管理类：设定目录时映射其下的全部残局库文件，之后多个搜索线程可不加锁同时探查（设定目录须在搜索之外进行）
+class TablebaseManager {
+
+public:
+    // 设定残局库目录（空为不使用），已映射的文件全部关闭；目录下没有残局库文件时同样不使用
+    static void setPath(const string& path);
+    static bool isEnabled() { return enabled_; }
+
+    // 规范的组合名称：须各有一个将帅，其余棋子不超过MaxPieceNum，否则返回空串
+    static string getName(const string& pieceChars);
+
+    // 探查color方走的局面：找到则返回true，wdl为走子方胜1、负-1、和0，plies为胜负的步数（只有WDL文件时为-1）
+    static bool probe(const Board& board, PieceColor color, int& wdl, int& plies);
+
+    // 生成组合的残局库（先生成吃子后的各组合），文件已存在的跳过；写入path目录
+    // 距胜负超过253步（DTM值为1字节）的组合不能生成，返回false
+    static bool generate(const string& name, const string& path,
+        int threadNum = thread::hardware_concurrency(), bool isVerbose = true);
+
+private:
+    static atomic<bool> enabled_;
+    static map<string, unique_ptr<Tablebase>> tables_;
+
+    static const Tablebase* __getTablebase(const string& name);
+    static bool __generate(const string& name, const string& path, int threadNum, bool isVerbose);
+};
+}
+
+#endif
@@ -2,12 +2,651 @@
 //
 #include "Board.h"
 #include "ChessManual.h"
+#include "Evaluate.h"
+#include "Mate.h"
+#include "Nnue.h"
+#include "Piece.h"
+#include "Search.h"
+#include "Seat.h"
+#include "Tablebase.h"
 #include "Tools.h"
 
 #include <chrono>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
 #include <locale>
+#include <mutex>
+
+// 走子生成器计数测试的初始局面：FEN为空则取初始布局
+static Board getPerftBoard(const string& fen)
+{
+    wstring FEN{ fen.empty() ? PieceManager::FirstFEN() : wstring(fen.begin(), fen.end()) };
+    return Board{ FENTopieChars(FENplusToFEN(FEN)) };
+}
+
+// 走子生成器计数测试：逐层输出叶结点数量及每秒结点数
+static void perftMode(int depth, const string& fen, const string& side)
+{
+    using namespace std::chrono;
+    Board board{ getPerftBoard(fen) };
+    PieceColor color{ side == "b" ? PieceColor::BLACK : PieceColor::RED };
+
+    for (int d = 1; d <= depth; ++d) {
+        auto time0 = steady_clock::now();
+        long long nodes{ board.perft(color, d) };
+        double secs{ duration_cast<microseconds>(steady_clock::now() - time0).count() / 1000000.0 };
+        std::cout << "perft(" << d << ") = " << nodes << "  time: " << secs << "s"
+                  << "  nps: " << static_cast<long long>(secs > 0 ? nodes / secs : 0) << '\n';
+    }
+}
+
+// 多线程分解计数：输出每一根着法（ICCS格式）的叶结点数量
+static void divideMode(int depth, const string& fen, const string& side, int threadNum)
+{
+    using namespace std::chrono;
+    Board board{ getPerftBoard(fen) };
+    PieceColor color{ side == "b" ? PieceColor::BLACK : PieceColor::RED };
+
+    auto time0 = steady_clock::now();
+    long long nodes{ 0 };
+    for (auto& count : board.perftDivide(color, depth, threadNum)) {
+        auto &frowcol = count.first.first, &trowcol = count.first.second;
+        std::cout << static_cast<char>(PieceManager::getColICCSChar(frowcol.second)) << frowcol.first
+                  << static_cast<char>(PieceManager::getColICCSChar(trowcol.second)) << trowcol.first
+                  << ": " << count.second << '\n';
+        nodes += count.second;
+    }
+    double secs{ duration_cast<microseconds>(steady_clock::now() - time0).count() / 1000000.0 };
+    std::cout << "divide(" << depth << ") = " << nodes << "  threads: " << threadNum
+              << "  time: " << secs << "s"
+              << "  nps: " << static_cast<long long>(secs > 0 ? nodes / secs : 0) << '\n';
+}
+
+// 搜索：输出最佳着法、分数、主要变例及每秒结点数
+static void searchMode(int depth, const string& fen, const string& side, int time, int threadNum)
+{
+    Board board{ getPerftBoard(fen) };
+    PieceColor color{ side == "b" ? PieceColor::BLACK : PieceColor::RED };
+    TransTable transTable{};
+    SMPSearch search{ board, color, transTable, threadNum };
+    SearchResult result{ search.search(SearchLimits{ depth, 0, time }) };
+
+    std::cout << "bestmove " << (result.move ? PieceManager::getMoveICCS(result.move) : "(none)")
+              << "  score: " << result.score << "  depth: " << result.depth << "\npv:";
+    for (auto move : result.pv)
+        std::cout << ' ' << PieceManager::getMoveICCS(move);
+    std::cout << "\nnodes: " << result.nodes << "  time: " << result.time / 1000.0 << "s"
+              << "  nps: " << (result.time > 0 ? result.nodes * 1000 / result.time : 0) << '\n';
+}
+
+// 多变例分析：搜索棋谱起始局面（走子方为主线第一着的一方）的前multiPV个变例并输出；
+// 给出输出文件时各变例加入起始局面（注解为深度、分数），按输出文件的格式写入
+static void analyzeMode(const string& infile, int depth, int multiPV, int threadNum, const string& outfile)
+{
+    ChessManual manual{ infile };
+    Board board{ manual.getStartPieceChars() };
+    vector<MoveCode> mainMoves{ manual.getMainMoves() };
+    PieceColor color{ mainMoves.empty() ? PieceColor::RED
+                                        : PieceManager::getColor(board.getPieceChars()[MoveList::fromIndex(mainMoves[0])]) };
+    TransTable transTable{ 64 };
+    SMPSearch search{ board, color, transTable, threadNum };
+    search.setMultiPV(multiPV);
+    SearchResult result{ search.search(SearchLimits{ depth, 0, 0 }) };
+
+    vector<vector<MoveCode>> lines{};
+    vector<wstring> remarks{};
+    for (size_t index = 0; index < result.lines.size(); ++index) {
+        auto& line = result.lines[index];
+        std::cout << index + 1 << ". score: " << line.score << "  pv:";
+        for (auto move : line.pv)
+            std::cout << ' ' << PieceManager::getMoveICCS(move);
+        std::cout << '\n';
+        lines.push_back(line.pv);
+        remarks.push_back(L"变例" + std::to_wstring(index + 1) + L"：深度" + std::to_wstring(result.depth)
+            + L"，分数" + std::to_wstring(line.score));
+    }
+    std::cout << "depth: " << result.depth << "  nodes: " << result.nodes << "  time: " << result.time / 1000.0 << "s\n";
+    if (!outfile.empty()) {
+        manual.addRootVariations(lines, remarks);
+        manual.write(outfile);
+    }
+}
+
+// 多线程搜索测试：以1/2/4/8/16个线程搜索至同一深度，输出用时、每秒结点数及相对单线程的加速比
+static void smpBenchMode(int depth, const string& fen, const string& side)
+{
+    Board board{ getPerftBoard(fen) };
+    PieceColor color{ side == "b" ? PieceColor::BLACK : PieceColor::RED };
+    TransTable transTable{ 64 };
+    int time1{ 0 };
+    std::cout << "threads  depth      time         nodes        nps  speedup\n";
+    for (int threadNum : { 1, 2, 4, 8, 16 }) {
+        transTable.clear();
+        transTable.newSearch();
+        SMPSearch search{ board, color, transTable, threadNum };
+        SearchResult result{ search.search(SearchLimits{ depth, 0, 0 }) };
+        int time{ max(result.time, 1) };
+        if (threadNum == 1)
+            time1 = time;
+        std::cout << std::setw(7) << threadNum << std::setw(7) << result.depth
+                  << std::setw(9) << time << "ms" << std::setw(14) << result.nodes
+                  << std::setw(11) << result.nodes * 1000 / time
+                  << std::setw(9) << std::fixed << std::setprecision(2) << static_cast<double>(time1) / time << '\n';
+    }
+}
+
+// 基准测试的局面（红方走）：初始局面、残局及若干中局，改动时须增加版本号（结点数随之不同）
+static constexpr int BenchVersion{ 1 }, BenchDepth{ 10 };
+static const char* const BenchFENs[]{
+    "rnbakabnr/9/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C5C1/9/RNBAKABNR",
+    "5a3/4ak2r/6R2/8p/9/9/9/B4N2B/4K4/3c5",
+    "r1ba1a3/4kn3/2n1b4/pNp1p1p1p/4c4/6P2/P1P2R2P/1CcC5/9/2BAKAB2",
+    "1C2ka3/9/C1Nab1n2/p3p3p/6p2/9/P3P3P/3AB4/3p2c2/c1BAK4",
+    "1rbak1br1/4a3c/c1n3n2/pC2p1R1p/2p6/6P2/P1P1P3P/2N1C1N2/9/1RBAKAB2",
+    "1rbakab2/9/2n1c1n2/pC2p1prp/2p6/5NP2/P1P1P2cP/2N1C4/9/1RBAKABR1",
+    "1rbakabr1/9/2n3n2/p1p1p3p/7c1/2P3pC1/Pc2P3P/N1C3N2/9/1RBAKABR1"
+};
+
+// 基准测试：单线程依次搜索各局面至同一深度（每个局面清空置换表），输出各局面及总的结点数、用时、每秒结点数
+// 总结点数为本版本程序的搜索特征值（搜索、评估有改动才会变化）；options为关闭的裁剪，如"nullmove,lmr"，供对比测试
+// 评估固定为子力及位置价值（不使用启动时载入的网络），给出nnueFile时使用该网络；输出所用的评估
+static void benchMode(int depth, const string& options, const string& nnueFile)
+{
+    if (nnueFile.empty())
+        NnueManager::unload();
+    else if (!NnueManager::load(nnueFile)) {
+        std::cout << "can't load nnue file " << nnueFile << '\n';
+        return;
+    }
+    SearchOptions searchOptions{};
+    searchOptions.nullMove = options.find("nullmove") == string::npos;
+    searchOptions.lmr = options.find("lmr") == string::npos;
+    searchOptions.futility = options.find("futility") == string::npos;
+    searchOptions.razoring = options.find("razoring") == string::npos;
+    TransTable transTable{ 16 };
+    long long totalNodes{ 0 };
+    int totalTime{ 0 };
+    std::cout << "bench version " << BenchVersion << "  depth " << depth
+              << "  eval " << (nnueFile.empty() ? "psqt" : "nnue " + nnueFile) << '\n';
+    for (auto fen : BenchFENs) {
+        transTable.clear();
+        transTable.newSearch();
+        SMPSearch search{ getPerftBoard(fen), PieceColor::RED, transTable, 1 };
+        search.setOptions(searchOptions);
+        SearchResult result{ search.search(SearchLimits{ depth, 0, 0 }) };
+        totalNodes += result.nodes;
+        totalTime += result.time;
+        std::cout << std::setw(12) << result.nodes << std::setw(8) << result.time << "ms  "
+                  << (result.move ? PieceManager::getMoveICCS(result.move) : "(none)") << "  " << fen << '\n';
+    }
+    std::cout << "nodes: " << totalNodes << "  time: " << totalTime / 1000.0 << "s"
+              << "  nps: " << (totalTime > 0 ? totalNodes * 1000 / totalTime : 0)
+              << "  eval: " << (nnueFile.empty() ? "psqt" : "nnue " + nnueFile) << '\n';
+}
+
+// 输出一项检验的结果，返回失败数
+static int reportCheck(const string& name, int count, int failed)
+{
+    std::cout << name << ": " << count << " checked, " << (failed ? std::to_string(failed) + " failed" : "ok") << '\n';
+    return failed;
+}
+
+// 回归检验的神经网络：随机参数，自各局面随机走子，每步对照增量更新及SIMD指令计算与标量从头计算的评估
+static constexpr unsigned CheckNnueSeed{ 1 };
+static constexpr int CheckNnuePlies{ 80 };
+
+static int checkNnue()
+{
+    NnueManager::setRandom(CheckNnueSeed);
+    mt19937 engine{ CheckNnueSeed };
+    int count{ 0 }, failed{ 0 };
+    auto __check = [&](const Board& board, const char* fen) {
+        for (auto color : { PieceColor::RED, PieceColor::BLACK }) {
+            ++count;
+            int value{ board.evaluate(color) }, scalarValue{ board.evaluateScalar(color) };
+            if (value != scalarValue && ++failed <= 10)
+                std::cout << "  evaluate " << value << ", scalar " << scalarValue << "  from " << fen << '\n';
+        }
+    };
+    for (auto fen : BenchFENs) {
+        Board board{ getPerftBoard(fen) };
+        PieceColor color{ PieceColor::RED };
+        vector<pair<MoveCode, SPiece>> moveds{};
+        __check(board, fen);
+        for (int ply = 0; ply < CheckNnuePlies; ++ply) {
+            MoveList moves{};
+            board.getCanMoves(moves, color, true);
+            board.getCanMoves(moves, color, false);
+            if (moves.empty())
+                break;
+            MoveCode move{ moves[engine() % moves.size()] };
+            moveds.emplace_back(move, board.movTo(move));
+            __check(board, fen);
+            color = PieceManager::getOtherColor(color);
+        }
+        // 退回时同样增量更新
+        for (auto moved = moveds.rbegin(); moved != moveds.rend(); ++moved) {
+            board.movBack(moved->first, moved->second);
+            __check(board, fen);
+        }
+    }
+    NnueManager::unload();
+    return reportCheck("nnue", count, failed);
+}
+
+// 回归检验的走子生成器计数：FEN、走子方及深度1至4的叶结点数量
+struct PerftReference {
+    const char* fen;
+    const char* side;
+    long long nodes[4];
+};
+
+static const PerftReference PerftReferences[]{
+    { "rnbakabnr/9/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C5C1/9/RNBAKABNR", "r", { 44, 1920, 79666, 3290240 } },
+    { "RNBAKABNR/9/1C5C1/P1P1P1P1P/9/9/p1p1p1p1p/1c5c1/9/rnbakabnr", "b", { 44, 1920, 79666, 3290240 } },
+    { "5a3/4ak2r/6R2/8p/9/9/9/B4N2B/4K4/3c5", "r", { 33, 737, 21450, 448581 } },
+    { "r1ba1a3/4kn3/2n1b4/pNp1p1p1p/4c4/6P2/P1P2R2P/1CcC5/9/2BAKAB2", "r", { 38, 1128, 43929, 1339047 } },
+    { "C1nNk4/9/9/9/9/9/n1pp5/B3C4/9/3A1K3", "r", { 28, 222, 6241, 64971 } },
+    { "4ka3/4a4/9/9/4N4/p8/9/4C3c/7n1/2BK5", "r", { 23, 345, 8124, 149272 } },
+    { "2b1ka3/9/b3N4/4n4/9/9/9/4C4/2p6/2BK5", "r", { 21, 195, 3883, 48060 } },
+    { "1C2ka3/9/C1Nab1n2/p3p3p/6p2/9/P3P3P/3AB4/3p2c2/c1BAK4", "r", { 30, 830, 22787, 649866 } },
+    { "1C2ka3/9/C1Nab1n2/p3p3p/6p2/9/P3P3P/3AB4/3p2c2/c1BAK4", "b", { 29, 821, 22672, 627039 } },
+    { "3k5/4P4/9/9/9/9/9/9/4p4/5K3", "r", { 3, 9, 20, 77 } }
+};
+
+static int checkPerft()
+{
+    int count{ 0 }, failed{ 0 };
+    for (auto& reference : PerftReferences) {
+        Board board{ getPerftBoard(reference.fen) };
+        PieceColor color{ string(reference.side) == "b" ? PieceColor::BLACK : PieceColor::RED };
+        for (int depth = 1; depth <= 4; ++depth, ++count) {
+            long long nodes{ board.perft(color, depth) };
+            if (nodes != reference.nodes[depth - 1]) {
+                ++failed;
+                std::cout << "  perft(" << depth << ") = " << nodes << ", expected " << reference.nodes[depth - 1]
+                          << "  " << reference.fen << ' ' << reference.side << '\n';
+            }
+        }
+    }
+    return reportCheck("perft", count, failed);
+}
+
+// 信箱棋盘的走子生成器：各参考局面每一根着法之后，以信箱棋盘与棋盘的走子生成器计数对照（深度同checkPerft）
+static int checkMailbox()
+{
+    int count{ 0 }, failed{ 0 };
+    for (auto& reference : PerftReferences) {
+        Board board{ getPerftBoard(reference.fen) };
+        PieceColor color{ string(reference.side) == "b" ? PieceColor::BLACK : PieceColor::RED },
+            othColor{ PieceManager::getOtherColor(color) };
+        MoveList moves{};
+        board.getCanMoves(moves, color, true);
+        board.getCanMoves(moves, color, false);
+        for (auto move : moves) {
+            ++count;
+            auto eatPiece = board.movTo(move);
+            long long nodes{ board.perft(othColor, 3) }, mailboxNodes{ board.perftMailbox(othColor, 3) };
+            board.movBack(move, eatPiece);
+            if (nodes != mailboxNodes) {
+                ++failed;
+                std::cout << "  " << PieceManager::getMoveICCS(move) << ": mailbox " << mailboxNodes << ", board " << nodes
+                          << "  " << reference.fen << ' ' << reference.side << '\n';
+            }
+        }
+    }
+    return reportCheck("mailbox", count, failed);
+}
+
+// 回归检验的连将杀（红方先走）：FEN、限定步数及最少步数（0为限定步数以内无杀），步数均已与残局库的距胜步数核对
+struct MateReference {
+    const char* fen;
+    int maxSteps;
+    int steps;
+};
+
+static const MateReference MateReferences[]{
+    { "4k4/4a4/b8/9/1R7/9/9/9/4K4/9", 3, 2 },
+    { "3k5/9/1R1ab4/9/9/9/9/9/4K4/9", 4, 3 },
+    { "9/4k4/9/3R5/3N5/9/9/3K5/9/9", 4, 3 },
+    { "rnbakabnr/9/1c5c1/p1p1p1p1p/9/9/P1P1P1P1P/1C5C1/9/RNBAKABNR", 3, 0 }
+};
+
+static int checkMate()
+{
+    int count{ 0 }, failed{ 0 };
+    for (auto& reference : MateReferences) {
+        ++count;
+        MateSolver solver{ getPerftBoard(reference.fen), PieceColor::RED };
+        int steps{ solver.solve(reference.maxSteps) };
+        if (steps != reference.steps) {
+            ++failed;
+            std::cout << "  mate steps " << steps << ", expected " << reference.steps << "  " << reference.fen << '\n';
+        }
+    }
+    return reportCheck("mate", count, failed);
+}
+
+// 回归检验的残局库组合：生成于给定目录（已存在的直接使用），随机取局面的探查结果与关闭裁剪的搜索结果对照
+static const char* const CheckTablebases[]{ "KRka", "KRkb", "KNRk" };
+static constexpr int CheckTbSamples{ 40 }, CheckTbDepth{ 9 };
+
+static int checkTablebase(const string& path, int threadNum)
+{
+    struct Sample {
+        wstring pieceChars;
+        PieceColor color;
+        int wdl, plies;
+    };
+    mt19937 engine{ 1 };
+    vector<Sample> samples{};
+    int count{ 0 }, failed{ 0 };
+    for (auto name : CheckTablebases) {
+        if (!TablebaseManager::generate(name, path, threadNum, false)) {
+            ++failed;
+            std::cout << "  can't generate tablebase " << name << '\n';
+            continue;
+        }
+        TablebaseManager::setPath(path);
+        Tablebase table{ name };
+        for (int sampleNum = 0; sampleNum < CheckTbSamples;) {
+            int indexs[Tablebase::MaxPieceNum]{};
+            table.getIndexs(engine() % table.size(), indexs);
+            wstring pieceChars(SEATNUM, PieceManager::nullChar());
+            bool isOverlap{ false };
+            for (size_t i = 0; i < table.pieces().size(); ++i) {
+                isOverlap = isOverlap || pieceChars[indexs[i]] != PieceManager::nullChar();
+                pieceChars[indexs[i]] = name[i];
+            }
+            if (isOverlap)
+                continue;
+            PieceColor color{ sampleNum % 2 ? PieceColor::BLACK : PieceColor::RED };
+            Board board{ pieceChars };
+            int wdl{}, plies{};
+            if (board.isKilled(PieceManager::getOtherColor(color)))
+                continue;
+            if (!TablebaseManager::probe(board, color, wdl, plies)) {
+                ++failed;
+                std::cout << "  can't probe " << name << '\n';
+                break;
+            }
+            samples.push_back(Sample{ pieceChars, color, wdl, plies });
+            ++sampleNum;
+        }
+    }
+
+    // 搜索时不使用残局库：胜负在搜索深度以内的须为同样步数的将死分数，和棋不得为将死分数
+    TablebaseManager::setPath("");
+    TransTable transTable{ 4 };
+    for (auto& sample : samples) {
+        ++count;
+        transTable.clear();
+        transTable.newSearch();
+        Search search{ Board{ sample.pieceChars }, sample.color, transTable };
+        search.setOptions(SearchOptions{ false, false, false, false });
+        int score{ search.search(SearchLimits{ CheckTbDepth, 0, 0 }).score };
+        bool isInDepth{ sample.plies <= CheckTbDepth - 2 },
+            isOk{ sample.wdl == 0 ? !Search::isMateScore(score)
+                                  : (!isInDepth || score == (Search::MateValue - sample.plies) * sample.wdl) };
+        if (!isOk && ++failed <= 10) {
+            wstring fen{ pieCharsToFEN(sample.pieceChars) };
+            std::cout << "  wdl " << sample.wdl << ", plies " << sample.plies << ", search " << score << "  "
+                      << string(fen.begin(), fen.end()) << (sample.color == PieceColor::RED ? " r" : " b") << '\n';
+        }
+    }
+    return reportCheck("tablebase", count, failed);
+}
+
+// 回归检验：走子生成器计数（另以信箱棋盘对照）、神经网络计算（随机网络，对照标量计算）、连将杀，给出目录时另检验残局库；输出各项结果及失败总数
+// 评估固定为子力及位置价值（不使用启动时载入的网络）
+static void checkMode(const string& tbPath, int threadNum)
+{
+    int failed{ checkPerft() + checkMailbox() + checkNnue() + checkMate() };
+    if (!tbPath.empty())
+        failed += checkTablebase(tbPath, threadNum);
+    std::cout << (failed ? "check failed: " + std::to_string(failed) : string("check passed")) << '\n';
+}
+
+// 启动时载入的神经网络文件（当前目录下），不存在则使用子力及位置价值评估
+static const string NnueFileName{ "cchess_vs.nnue" };
+
+// UCCI引擎：当前局面、共享置换表及后台搜索线程
+// 搜索在后台线程进行，输入线程可随时以stop、ponderhit干预；输出经互斥量逐行写出
+class UcciEngine {
+
+public:
+    void run()
+    {
+        string line{};
+        while (std::getline(std::cin, line)) {
+            std::istringstream iss{ line };
+            string command{};
+            iss >> command;
+            if (command == "ucci") {
+                __output("id name cchess_vs\n"
+                         "option hashsize type spin min 1 max 1024 default 16\n"
+                         "option threads type spin min 1 max 64 default 1\n"
+                         "option multipv type spin min 1 max 32 default 1\n"
+                         "option nullmove type check default true\n"
+                         "option lmr type check default true\n"
+                         "option futility type check default true\n"
+                         "option razoring type check default true\n"
+                         "option tbpath type string default <empty>\n"
+                         "option evalfile type string default <empty>\n"
+                         "option nnuefile type string default "
+                    + NnueFileName + "\nucciok");
+            } else if (command == "isready")
+                __output("readyok");
+            else if (command == "setoption")
+                __setOption(iss);
+            else if (command == "position") {
+                __stopSearch();
+                __setPosition(iss);
+            } else if (command == "go") {
+                __stopSearch();
+                __go(iss);
+            } else if (command == "ponderhit")
+                __ponderHit();
+            else if (command == "stop")
+                __stopSearch();
+            else if (command == "quit") {
+                __stopSearch();
+                __output("bye");
+                break;
+            }
+        }
+        __stopSearch();
+    }
+
+private:
+    Board board_{ FENTopieChars(PieceManager::FirstFEN()) };
+    PieceColor color_{ PieceColor::RED };
+    TransTable transTable_{};
+    int threadNum_{ 1 }, multiPV_{ 1 };
+    SearchOptions options_{};
+
+    unique_ptr<SMPSearch> search_{};
+    std::thread searchThread_{};
+    std::chrono::steady_clock::time_point goTime_{};
+    int ponderTime_{ 0 }; // 后台思考命中后可用的时间（毫秒）
+    bool pondering_{ false };
+    std::mutex mutex_{};
+    std::condition_variable ponderCond_{};
+
+    void __output(const string& str)
+    {
+        std::lock_guard<std::mutex> lock{ mutex_ };
+        std::cout << str << std::endl;
+    }
+
+    // setoption hashsize <MB> | threads <n> | multipv <n> | nullmove|lmr|futility|razoring <true|false> | tbpath <目录>
+    //     | evalfile <文件名> | nnuefile <文件名>
+    void __setOption(std::istringstream& iss)
+    {
+        string name{}, value{};
+        if (!(iss >> name >> value))
+            return;
+        __stopSearch();
+        if (name == "tbpath") {
+            TablebaseManager::setPath(value == "<empty>" ? string{} : value);
+            return;
+        }
+        if (name == "evalfile" || name == "nnuefile") {
+            if (!(name == "evalfile" ? EvalManager::load(value) : NnueManager::load(value)))
+                __output("info string can't load " + name + " " + value);
+            return;
+        }
+        bool* option{ name == "nullmove" ? &options_.nullMove
+                : name == "lmr"              ? &options_.lmr
+                : name == "futility"         ? &options_.futility
+                : name == "razoring"         ? &options_.razoring
+                                             : nullptr };
+        if (option) {
+            *option = value == "true" || value == "on";
+            return;
+        }
+        int number{ std::atoi(value.c_str()) };
+        if (number <= 0)
+            return;
+        if (name == "hashsize")
+            transTable_.resize(number);
+        else if (name == "threads")
+            threadNum_ = number;
+        else if (name == "multipv")
+            multiPV_ = number;
+    }
+
+    // position {fen <FEN> | startpos} [moves <move1> ...]：着法不合法则忽略其后的着法
+    void __setPosition(std::istringstream& iss)
+    {
+        string token{}, fen{}, side{ "r" };
+        iss >> token;
+        if (token == "fen") {
+            iss >> fen >> side;
+            while (iss >> token && token != "moves")
+                ;
+        } else if (token == "startpos")
+            iss >> token;
+        else
+            return;
+
+        board_.setPieces(FENTopieChars(fen.empty() ? PieceManager::FirstFEN() : wstring(fen.begin(), fen.end())));
+        color_ = side == "b" ? PieceColor::BLACK : PieceColor::RED;
+        while (iss >> token) {
+            MoveCode move{ PieceManager::getICCSMove(token) };
+            MoveList moves{};
+            board_.getCanMoves(moves, color_, true);
+            board_.getCanMoves(moves, color_, false);
+            if (!move || std::find(moves.begin(), moves.end(), move) == moves.end())
+                break;
+            board_.movTo(move);
+            color_ = PieceManager::getOtherColor(color_);
+        }
+    }
+
+    // go [ponder] [depth <d> | nodes <n> | time <ms> [movestogo <n>] [increment <ms>] | infinite]
+    void __go(std::istringstream& iss)
+    {
+        SearchLimits limits{ 0, 0, 0 };
+        int time{ 0 }, movesToGo{ 0 }, increment{ 0 };
+        bool ponder{ false };
+        string token{};
+        while (iss >> token) {
+            if (token == "ponder")
+                ponder = true;
+            else if (token == "depth")
+                iss >> limits.depth;
+            else if (token == "nodes")
+                iss >> limits.nodes;
+            else if (token == "time")
+                iss >> time;
+            else if (token == "movestogo")
+                iss >> movesToGo;
+            else if (token == "increment")
+                iss >> increment;
+        }
+        // 本步用时：余下时间按步数（未指定则按30步）平分，加上每步加时，不超过余下时间的一半
+        if (time > 0)
+            limits.time = max(min(time / (movesToGo > 0 ? movesToGo : 30) + increment, time / 2), 1);
+        ponderTime_ = limits.time;
+        if (ponder)
+            limits.time = 0; // 后台思考不限时，命中后再设定
+
+        transTable_.newSearch();
+        search_ = std::make_unique<SMPSearch>(board_, color_, transTable_, threadNum_);
+        search_->setOptions(options_);
+        search_->setMultiPV(multiPV_);
+        search_->setInfoHandler([this](const SearchResult& result) { __outputInfo(result); });
+        goTime_ = std::chrono::steady_clock::now();
+        pondering_ = ponder;
+        searchThread_ = std::thread([this, limits] {
+            SearchResult result{ search_->search(limits) };
+            {
+                // 后台思考中途完成的，等到命中或停止时才给出着法
+                std::unique_lock<std::mutex> lock{ mutex_ };
+                ponderCond_.wait(lock, [this] { return !pondering_; });
+            }
+            if (!result.move)
+                __output("nobestmove");
+            else
+                __output("bestmove " + PieceManager::getMoveICCS(result.move)
+                    + (result.pv.size() > 1 ? " ponder " + PieceManager::getMoveICCS(result.pv[1]) : ""));
+        });
+    }
+
+    // info depth <d> [multipv <k>] score <s> time <ms> nodes <n> nps <n> hashfull <permille> pv <moves>
+    // 多变例时每个变例一行，按分数由高到低
+    void __outputInfo(const SearchResult& result)
+    {
+        for (size_t index = 0; index < result.lines.size(); ++index) {
+            auto& line = result.lines[index];
+            std::ostringstream oss{};
+            oss << "info depth " << result.depth;
+            if (result.lines.size() > 1)
+                oss << " multipv " << index + 1;
+            oss << " score " << line.score << " time " << result.time
+                << " nodes " << result.nodes << " nps " << (result.time > 0 ? result.nodes * 1000 / result.time : 0)
+                << " hashfull " << transTable_.hashfull() << " pv";
+            for (auto move : line.pv)
+                oss << ' ' << PieceManager::getMoveICCS(move);
+            __output(oss.str());
+        }
+    }
+
+    // 后台思考命中：转为正常思考，用时自命中时起计
+    void __ponderHit()
+    {
+        if (!search_)
+            return;
+        if (ponderTime_ > 0) {
+            using namespace std::chrono;
+            int elapsed{ static_cast<int>(duration_cast<milliseconds>(steady_clock::now() - goTime_).count()) };
+            search_->setTimeLimit(elapsed + ponderTime_);
+        }
+        __endPonder();
+    }
+
+    void __endPonder()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ mutex_ };
+            pondering_ = false;
+        }
+        ponderCond_.notify_all();
+    }
+
+    // 停止正在进行的搜索并等待其给出着法
+    void __stopSearch()
+    {
+        if (!searchThread_.joinable())
+            return;
+        search_->stop();
+        __endPonder();
+        searchThread_.join();
+        search_.reset();
+    }
+};
 
 int main(int argc, char const* argv[])
 {
@@ -16,6 +655,13 @@ int main(int argc, char const* argv[])
         //std::locale loc = std::locale::global(std::locale(""));
         setlocale(LC_ALL, "chs");
         std::ios_base::sync_with_stdio(false);
+        NnueManager::load(NnueFileName);
+
+        // cchess_vs ucci：按UCCI协议从标准输入读取命令
+        if (argc > 1 && string(argv[1]) == "ucci") {
+            UcciEngine{}.run();
+            return 0;
+        }
 
         auto time0 = steady_clock::now();
 
@@ -26,7 +672,42 @@ int main(int argc, char const* argv[])
         ofs.close();
         //*/
         //Tools::writeFile(fname, testBoard());
-        std::wcout << testBoard();
+        // cchess_vs perft depth [FEN] [r|b]
+        // cchess_vs divide depth [FEN] [r|b] [threads]
+        // cchess_vs search depth [FEN] [r|b] [time(ms)] [threads]
+        // cchess_vs smpbench depth [FEN] [r|b]
+        // cchess_vs bench [depth] [options] [nnueFile]：基准测试，options为关闭的裁剪，如 nullmove,lmr（不关闭则为-）
+        // cchess_vs analyze file depth [multiPV] [threads] [outfile]：多变例分析棋谱的起始局面
+        // cchess_vs tbgen material [dir] [threads]：生成残局库，如 tbgen KRkaabb
+        // cchess_vs mate dir [maxSteps] [threads] [remark]：检验目录下的杀着棋谱，remark为1时结论写回棋谱
+        // cchess_vs check [tbdir] [threads]：回归检验，给出目录时另生成、检验残局库
+        if (argc > 2 && string(argv[1]) == "perft")
+            perftMode(std::stoi(argv[2]), argc > 3 ? argv[3] : "", argc > 4 ? argv[4] : "r");
+        else if (argc > 2 && string(argv[1]) == "divide")
+            divideMode(std::stoi(argv[2]), argc > 3 ? argv[3] : "", argc > 4 ? argv[4] : "r",
+                argc > 5 ? std::stoi(argv[5]) : std::thread::hardware_concurrency());
+        else if (argc > 2 && string(argv[1]) == "search")
+            searchMode(std::stoi(argv[2]), argc > 3 ? argv[3] : "", argc > 4 ? argv[4] : "r",
+                argc > 5 ? std::stoi(argv[5]) : 0, argc > 6 ? std::stoi(argv[6]) : 1);
+        else if (argc > 2 && string(argv[1]) == "smpbench")
+            smpBenchMode(std::stoi(argv[2]), argc > 3 ? argv[3] : "", argc > 4 ? argv[4] : "r");
+        else if (argc > 1 && string(argv[1]) == "bench")
+            benchMode(argc > 2 ? std::stoi(argv[2]) : BenchDepth, argc > 3 ? argv[3] : "", argc > 4 ? argv[4] : "");
+        else if (argc > 3 && string(argv[1]) == "analyze")
+            analyzeMode(argv[2], std::stoi(argv[3]), argc > 4 ? std::stoi(argv[4]) : 4,
+                argc > 5 ? std::stoi(argv[5]) : 1, argc > 6 ? argv[6] : "");
+        else if (argc > 2 && string(argv[1]) == "tbgen") {
+            if (!TablebaseManager::generate(argv[2], argc > 3 ? argv[3] : "",
+                    argc > 4 ? std::stoi(argv[4]) : std::thread::hardware_concurrency()))
+                std::cout << "can't generate tablebase " << argv[2] << '\n';
+        } else if (argc > 2 && string(argv[1]) == "mate") {
+            auto reports = MateManager::checkDir(argv[2], argc > 3 ? std::stoi(argv[3]) : MateManager::DefaultMaxSteps,
+                argc > 4 ? std::stoi(argv[4]) : std::thread::hardware_concurrency(), argc > 5 && string(argv[5]) == "1");
+            std::cout << reports.size() << " manuals checked, see " << argv[2] << '/' << MateManager::ReportFileName << '\n';
+        } else if (argc > 1 && string(argv[1]) == "check")
+            checkMode(argc > 2 ? argv[2] : "", argc > 3 ? std::stoi(argv[3]) : std::thread::hardware_concurrency());
+        else
+            std::wcout << testBoard();
         //std::wcout << testChessmanual();
         /*
         if (argc == 7)